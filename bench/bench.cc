@@ -0,0 +1,308 @@
+#include "bench.h"
+#include "utils/half.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <numeric>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define BENCH_X86 1
+#endif
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace infini {
+namespace bench {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double seconds(Clock::time_point begin) {
+    return std::chrono::duration<double>(Clock::now() - begin).count();
+}
+
+int numThreads() {
+#ifdef _OPENMP
+    return omp_get_max_threads();
+#else
+    return 1;
+#endif
+}
+
+// Each loop runs chains of dependent FMAs, enough of them to hide the FMA
+// latency, and returns flops per iteration. The sum is returned through
+// `sink` so that the loop is not optimized away.
+constexpr size_t fmaIterations = 1 << 24;
+
+size_t fmaGeneric(float *sink) {
+    constexpr int chains = 32;
+    float acc[chains];
+    for (int i = 0; i < chains; ++i)
+        acc[i] = float(i);
+    for (size_t it = 0; it < fmaIterations; ++it)
+        for (int i = 0; i < chains; ++i)
+            acc[i] = acc[i] * 0.999999f + 1e-6f;
+    *sink = std::accumulate(acc, acc + chains, 0.f);
+    return 2 * chains;
+}
+
+#ifdef BENCH_X86
+#define FMA_LOOP(vec, set1, fmadd, lanes)                                      \
+    vec a0 = set1(0), a1 = set1(1), a2 = set1(2), a3 = set1(3), a4 = set1(4),  \
+        a5 = set1(5), a6 = set1(6), a7 = set1(7), a8 = set1(8), a9 = set1(9);  \
+    const vec m = set1(0.999999f), c = set1(1e-6f);                            \
+    for (size_t it = 0; it < fmaIterations; ++it) {                            \
+        a0 = fmadd(a0, m, c);                                                  \
+        a1 = fmadd(a1, m, c);                                                  \
+        a2 = fmadd(a2, m, c);                                                  \
+        a3 = fmadd(a3, m, c);                                                  \
+        a4 = fmadd(a4, m, c);                                                  \
+        a5 = fmadd(a5, m, c);                                                  \
+        a6 = fmadd(a6, m, c);                                                  \
+        a7 = fmadd(a7, m, c);                                                  \
+        a8 = fmadd(a8, m, c);                                                  \
+        a9 = fmadd(a9, m, c);                                                  \
+    }                                                                          \
+    float out[lanes];
+
+__attribute__((target("avx2,fma"))) size_t fmaAvx2(float *sink) {
+    FMA_LOOP(__m256, _mm256_set1_ps, _mm256_fmadd_ps, 8)
+    _mm256_storeu_ps(out, _mm256_add_ps(_mm256_add_ps(a0, a1),
+                                        _mm256_add_ps(a8, a9)));
+    *sink = out[0] + out[7];
+    __m256 rest = _mm256_add_ps(_mm256_add_ps(a2, a3), _mm256_add_ps(a4, a5));
+    _mm256_storeu_ps(out, _mm256_add_ps(rest, _mm256_add_ps(a6, a7)));
+    *sink += out[0] + out[7];
+    return 2 * 10 * 8;
+}
+
+__attribute__((target("avx512f"))) size_t fmaAvx512(float *sink) {
+    FMA_LOOP(__m512, _mm512_set1_ps, _mm512_fmadd_ps, 16)
+    __m512 sum = _mm512_add_ps(_mm512_add_ps(a0, a1), _mm512_add_ps(a8, a9));
+    sum = _mm512_add_ps(sum, _mm512_add_ps(_mm512_add_ps(a2, a3),
+                                           _mm512_add_ps(a4, a5)));
+    _mm512_storeu_ps(out, _mm512_add_ps(sum, _mm512_add_ps(a6, a7)));
+    *sink = out[0] + out[15];
+    return 2 * 10 * 16;
+}
+#undef FMA_LOOP
+#endif
+
+double peakGflops(int threads) {
+    size_t (*loop)(float *) = fmaGeneric;
+#ifdef BENCH_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f"))
+        loop = fmaAvx512;
+    else if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+        loop = fmaAvx2;
+#endif
+    vector<float> sinks(threads);
+    double best = 0;
+    for (int rep = 0; rep < 3; ++rep) {
+        size_t perIteration = 0;
+        auto begin = Clock::now();
+#pragma omp parallel num_threads(threads)
+        {
+#ifdef _OPENMP
+            int id = omp_get_thread_num();
+#else
+            int id = 0;
+#endif
+            size_t flops = loop(&sinks[id]);
+            if (id == 0)
+                perIteration = flops;
+        }
+        double gflops =
+            double(perIteration) * fmaIterations * threads / seconds(begin);
+        best = std::max(best, gflops * 1e-9);
+    }
+    return best;
+}
+
+double peakGbps(int threads) {
+    constexpr size_t bytes = size_t(256) << 20;
+    constexpr size_t chunk = size_t(1) << 20;
+    vector<char> src(bytes, 1), dst(bytes, 0);
+    double best = 0;
+    for (int rep = 0; rep < 5; ++rep) {
+        auto begin = Clock::now();
+#pragma omp parallel for num_threads(threads)
+        for (size_t offset = 0; offset < bytes; offset += chunk)
+            std::memcpy(dst.data() + offset, src.data() + offset, chunk);
+        best = std::max(best, 2.0 * bytes / seconds(begin) * 1e-9);
+    }
+    return best;
+}
+
+Latency summarize(vector<double> samples) {
+    std::sort(samples.begin(), samples.end());
+    auto percentile = [&](double p) {
+        size_t i = size_t(p * (samples.size() - 1) + 0.5);
+        return samples[i];
+    };
+    Latency latency;
+    latency.iterations = samples.size();
+    latency.min = samples.front();
+    latency.mean = std::accumulate(samples.begin(), samples.end(), 0.0) /
+                   samples.size();
+    latency.p50 = percentile(0.5);
+    latency.p90 = percentile(0.9);
+    latency.p99 = percentile(0.99);
+    return latency;
+}
+
+string quote(const string &s) {
+    string out = "\"";
+    for (char c : s) {
+        if (c == '"' || c == '\\')
+            out += '\\';
+        out += c;
+    }
+    return out + "\"";
+}
+
+void writeResults(std::ostream &os, const vector<Result> &results) {
+    os << "[";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const auto &r = results[i];
+        const auto &l = r.latency;
+        os << (i ? "," : "") << "\n    {\"name\": " << quote(r.info.name)
+           << ", \"op\": " << quote(r.info.op)
+           << ", \"dtype\": " << quote(r.info.dtype)
+           << ", \"shape\": " << quote(r.info.shape)
+           << ", \"iterations\": " << l.iterations << ",\n     \"latency_us\": "
+           << "{\"min\": " << l.min << ", \"mean\": " << l.mean
+           << ", \"p50\": " << l.p50 << ", \"p90\": " << l.p90
+           << ", \"p99\": " << l.p99 << "},\n     \"flops\": " << r.info.flops
+           << ", \"bytes\": " << r.bytes << ", \"gflops\": " << r.gflops
+           << ", \"gbps\": " << r.gbps
+           << ", \"intensity\": " << r.intensity
+           << ", \"attainable_gflops\": " << r.attainable << "}";
+    }
+    os << (results.empty() ? "]" : "\n  ]");
+}
+
+} // namespace
+
+MachinePeak measurePeak() {
+    MachinePeak peak;
+    peak.threads = numThreads();
+    peak.gflops = peakGflops(peak.threads);
+    peak.gbps = peakGbps(peak.threads);
+    return peak;
+}
+
+void fill(const Tensor &tensor) {
+    auto dtype = tensor->getDType();
+    size_t n = tensor->size();
+    auto data = tensor->getRawDataPtr<void *>();
+    // small values of either sign, never zero so that Div stays finite
+    auto value = [](size_t i) {
+        return float(int(i * 7919 % 255) - 127) / 64.f + 1.f / 128;
+    };
+    if (dtype == DataType::Float32) {
+        auto ptr = static_cast<float *>(data);
+        for (size_t i = 0; i < n; ++i)
+            ptr[i] = value(i);
+    } else if (dtype == DataType::Float16 || dtype == DataType::BFloat16) {
+        auto ptr = static_cast<uint16_t *>(data);
+        for (size_t i = 0; i < n; ++i)
+            ptr[i] = dtype == DataType::Float16 ? fp32ToFp16(value(i))
+                                                : fp32ToBf16(value(i));
+    } else {
+        auto ptr = static_cast<uint8_t *>(data);
+        for (size_t i = 0; i < tensor->getBytes(); ++i)
+            ptr[i] = uint8_t(i * 7919 % 251 + 1);
+    }
+}
+
+Result runCase(const Case &c, const MachinePeak &peak, double minSeconds) {
+    Runtime runtime = NativeCpuRuntimeObj::getInstance();
+    Graph g = c.build(runtime);
+    g->dataMalloc();
+    for (auto &tensor : g->getTensors())
+        if (!tensor->getSource())
+            fill(tensor);
+    auto plan = runtime->compile(g);
+
+    Result result;
+    result.info = c;
+    for (auto &tensor : g->getTensors())
+        result.bytes += tensor->getBytes();
+
+    // Warm up caches, pages and thread pools, then time single runs.
+    for (int i = 0; i < 3; ++i)
+        runtime->run(plan);
+    vector<double> samples;
+    auto begin = Clock::now();
+    while (samples.size() < 10 ||
+           (seconds(begin) < minSeconds && samples.size() < 100000)) {
+        auto start = Clock::now();
+        runtime->run(plan);
+        samples.emplace_back(seconds(start) * 1e6);
+    }
+    result.latency = summarize(std::move(samples));
+
+    double median = result.latency.p50 * 1e-6;
+    result.gflops = c.flops / median * 1e-9;
+    result.gbps = result.bytes / median * 1e-9;
+    if (c.flops > 0) {
+        result.intensity = c.flops / result.bytes;
+        result.attainable =
+            std::min(peak.gflops, result.intensity * peak.gbps);
+    }
+    return result;
+}
+
+void printTable(std::ostream &os, const MachinePeak &peak,
+                const vector<Result> &kernels, const vector<Result> &graphs) {
+    auto flags = os.flags();
+    os << std::fixed << std::setprecision(1);
+    os << "threads " << peak.threads << ", peak " << peak.gflops
+       << " GFLOP/s, " << peak.gbps << " GB/s\n\n";
+    os << std::left << std::setw(44) << "kernel" << std::right
+       << std::setw(12) << "p50 us" << std::setw(10) << "GFLOP/s"
+       << std::setw(8) << "%peak" << std::setw(9) << "GB/s" << std::setw(8)
+       << "%peak" << std::setw(10) << "%roof" << "\n";
+    for (const auto &r : kernels) {
+        os << std::left << std::setw(44) << r.info.name << std::right
+           << std::setw(12) << r.latency.p50 << std::setw(10) << r.gflops
+           << std::setw(8) << 100 * r.gflops / peak.gflops << std::setw(9)
+           << r.gbps << std::setw(8) << 100 * r.gbps / peak.gbps;
+        // Against the roofline, or the copy bandwidth for pure data movement
+        double roof = r.attainable > 0 ? r.gflops / r.attainable
+                                       : r.gbps / peak.gbps;
+        os << std::setw(10) << 100 * roof << "\n";
+    }
+    if (!graphs.empty()) {
+        os << "\n"
+           << std::left << std::setw(44) << "graph" << std::right
+           << std::setw(12) << "p50 us" << std::setw(12) << "p90 us"
+           << std::setw(12) << "p99 us" << std::setw(12) << "mean us" << "\n";
+        for (const auto &r : graphs)
+            os << std::left << std::setw(44) << r.info.name << std::right
+               << std::setw(12) << r.latency.p50 << std::setw(12)
+               << r.latency.p90 << std::setw(12) << r.latency.p99
+               << std::setw(12) << r.latency.mean << "\n";
+    }
+    os.flags(flags);
+}
+
+void writeJson(std::ostream &os, const MachinePeak &peak,
+               const vector<Result> &kernels, const vector<Result> &graphs) {
+    os << "{\n  \"machine\": {\"threads\": " << peak.threads
+       << ", \"peak_gflops\": " << peak.gflops
+       << ", \"peak_gbps\": " << peak.gbps << "},\n  \"kernels\": ";
+    writeResults(os, kernels);
+    os << ",\n  \"graphs\": ";
+    writeResults(os, graphs);
+    os << "\n}\n";
+}
+
+} // namespace bench
+} // namespace infini
@@ -0,0 +1,64 @@
+#pragma once
+#ifndef BENCH_H
+#define BENCH_H
+
+#include "core/graph.h"
+#include "core/runtime.h"
+#include <functional>
+#include <ostream>
+
+namespace infini {
+namespace bench {
+
+// Peak compute and memory bandwidth of the machine, the roof of the
+// roofline every kernel is compared against.
+struct MachinePeak {
+    int threads = 1;
+    double gflops = 0; // fp32 FMA throughput of all threads
+    double gbps = 0;   // streaming copy bandwidth, read plus write
+};
+
+// Measure the peaks with an FMA loop on the widest vector unit available and
+// a parallel copy of buffers much larger than the caches.
+MachinePeak measurePeak();
+
+// Percentiles of per-iteration times, in microseconds.
+struct Latency {
+    size_t iterations = 0;
+    double min = 0, mean = 0, p50 = 0, p90 = 0, p99 = 0;
+};
+
+// A graph to be timed. flops is the arithmetic work of one run; the bytes
+// moved are taken as the size of every tensor in the graph, i.e. the traffic
+// of reading each input and writing each output once.
+struct Case {
+    string name, op, dtype, shape;
+    double flops = 0;
+    std::function<Graph(Runtime)> build;
+};
+
+struct Result {
+    Case info;
+    Latency latency;
+    double bytes = 0;
+    double gflops = 0, gbps = 0;
+    double intensity = 0;  // flops per byte
+    double attainable = 0; // roofline bound in GFLOP/s, 0 if flops are 0
+};
+
+// Build, allocate and compile the graph of `c`, fill its inputs, then run
+// the compiled plan until at least minSeconds have passed.
+Result runCase(const Case &c, const MachinePeak &peak, double minSeconds);
+
+// Fill a tensor with deterministic values that are valid for its type.
+void fill(const Tensor &tensor);
+
+void printTable(std::ostream &os, const MachinePeak &peak,
+                const vector<Result> &kernels, const vector<Result> &graphs);
+void writeJson(std::ostream &os, const MachinePeak &peak,
+               const vector<Result> &kernels, const vector<Result> &graphs);
+
+} // namespace bench
+} // namespace infini
+
+#endif
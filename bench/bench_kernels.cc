@@ -0,0 +1,299 @@
+#include "bench.h"
+#include "operators/concat.h"
+#include "operators/element_wise.h"
+#include "operators/matmul.h"
+#include "operators/transpose.h"
+#include "operators/unary.h"
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+
+using namespace infini;
+using namespace infini::bench;
+
+namespace {
+
+string dimsString(const Shape &dims) {
+    string s;
+    for (size_t i = 0; i < dims.size(); ++i)
+        s += (i ? "x" : "") + std::to_string(dims[i]);
+    return s;
+}
+
+double elements(const Shape &dims) {
+    double n = 1;
+    for (auto d : dims)
+        n *= d;
+    return n;
+}
+
+const vector<DataType> floatTypes = {DataType::Float32, DataType::Float16,
+                                     DataType::BFloat16};
+
+// Shapes are taken from transformer and MLP layers: hidden size 768, four
+// times that in the feed-forward layer, 12 heads of 64.
+vector<Case> kernelCases() {
+    vector<Case> cases;
+    auto add = [&](const string &op, DataType dtype, const string &shape,
+                   double flops, std::function<Graph(Runtime)> build) {
+        string dt = dtype.toString();
+        cases.push_back({op + "/" + dt + "/" + shape, op, dt, shape, flops,
+                         std::move(build)});
+    };
+
+    struct Gemm {
+        int batch, m, n, k;
+        bool transB, bias;
+    };
+    for (auto dtype : floatTypes)
+        for (auto s : {Gemm{1, 1, 3072, 768, false, true},
+                       Gemm{1, 512, 512, 512, false, false},
+                       Gemm{1, 128, 3072, 768, false, true},
+                       Gemm{1, 128, 768, 3072, true, true},
+                       Gemm{12, 128, 128, 64, true, false}}) {
+            if (!(dtype == DataType::Float32) && s.m == 1)
+                continue;
+            string shape = std::to_string(s.batch) + "x" +
+                           std::to_string(s.m) + "x" + std::to_string(s.n) +
+                           "x" + std::to_string(s.k) + (s.transB ? "^T" : "") +
+                           (s.bias ? "+bias" : "");
+            add("MatMul", dtype, shape, 2.0 * s.batch * s.m * s.n * s.k,
+                [=](Runtime runtime) {
+                    Graph g = make_ref<GraphObj>(runtime);
+                    auto a = g->addTensor({s.batch, s.m, s.k}, dtype);
+                    auto b = g->addTensor(s.transB ? Shape{s.n, s.k}
+                                                   : Shape{s.k, s.n},
+                                          dtype);
+                    auto bias = s.bias ? g->addTensor({s.n}, dtype) : nullptr;
+                    g->addOp<MatmulObj>(a, b, nullptr, false, s.transB, bias);
+                    return g;
+                });
+        }
+    for (auto s : {Gemm{1, 128, 3072, 768, false, true},
+                   Gemm{1, 512, 512, 512, false, false}}) {
+        string shape = std::to_string(s.m) + "x" + std::to_string(s.n) + "x" +
+                       std::to_string(s.k) + (s.bias ? "+bias" : "");
+        add("MatMul", DataType::UInt8, shape + "/q8", 2.0 * s.m * s.n * s.k,
+            [=](Runtime runtime) {
+                Graph g = make_ref<GraphObj>(runtime);
+                auto a = g->addTensor({s.m, s.k}, DataType::UInt8);
+                auto b = g->addTensor({s.k, s.n}, DataType::Int8);
+                auto bias = s.bias ? g->addTensor({s.n}, DataType::Float32)
+                                   : nullptr;
+                MatmulQuantization quant;
+                quant.scaleA = 0.02f;
+                quant.zeroA = 128;
+                quant.scaleB.assign(s.n, 0.01f);
+                g->addOp<MatmulObj>(a, b, nullptr, false, false, bias, quant);
+                return g;
+            });
+    }
+
+    for (auto dtype : floatTypes) {
+        Shape big{64, 128, 768};
+        auto binary = [&](const string &op, const Shape &b,
+                          std::function<void(Graph, Tensor, Tensor)> make) {
+            add(op, dtype, dimsString(big) + "," + dimsString(b),
+                elements(big), [=](Runtime runtime) {
+                    Graph g = make_ref<GraphObj>(runtime);
+                    make(g, g->addTensor(big, dtype), g->addTensor(b, dtype));
+                    return g;
+                });
+        };
+        binary("Add", {768}, [](Graph g, Tensor a, Tensor b) {
+            g->addOp<AddObj>(a, b, nullptr);
+        });
+        binary("Mul", big, [](Graph g, Tensor a, Tensor b) {
+            g->addOp<MulObj>(a, b, nullptr);
+        });
+        binary("Div", {64, 1, 768}, [](Graph g, Tensor a, Tensor b) {
+            g->addOp<DivObj>(a, b, nullptr);
+        });
+        add("Relu", dtype, dimsString(big), elements(big),
+            [=](Runtime runtime) {
+                Graph g = make_ref<GraphObj>(runtime);
+                g->addOp<ReluObj>(g->addTensor(big, dtype), nullptr);
+                return g;
+            });
+        add("Clip", dtype, dimsString(big), 2 * elements(big),
+            [=](Runtime runtime) {
+                Graph g = make_ref<GraphObj>(runtime);
+                g->addOp<ClipObj>(g->addTensor(big, dtype), nullptr, -1.f,
+                                  1.f);
+                return g;
+            });
+        // Sub, Mul and Relu fused by optimize into one pass
+        add("FusedElementWise", dtype, dimsString(big), 3 * elements(big),
+            [=](Runtime runtime) {
+                Graph g = make_ref<GraphObj>(runtime);
+                auto a = g->addTensor(big, dtype);
+                auto b = g->addTensor({768}, dtype);
+                auto c = g->addOp<SubObj>(a, b, nullptr)->getOutput();
+                auto d = g->addOp<MulObj>(c, a, nullptr)->getOutput();
+                g->addOp<ReluObj>(d, nullptr);
+                g->optimize();
+                return g;
+            });
+        add("Transpose", dtype, "64x128x12x64/0213", 0, [=](Runtime runtime) {
+            Graph g = make_ref<GraphObj>(runtime);
+            g->addOp<TransposeObj>(g->addTensor({64, 128, 12, 64}, dtype),
+                                   nullptr, vector<int>{0, 2, 1, 3});
+            return g;
+        });
+        add("Transpose", dtype, "4096x768/10", 0, [=](Runtime runtime) {
+            Graph g = make_ref<GraphObj>(runtime);
+            g->addOp<TransposeObj>(g->addTensor({4096, 768}, dtype), nullptr,
+                                   vector<int>{1, 0});
+            return g;
+        });
+        add("Concat", dtype, "3x64x128x256/axis2", 0, [=](Runtime runtime) {
+            Graph g = make_ref<GraphObj>(runtime);
+            TensorVec inputs;
+            for (int i = 0; i < 3; ++i)
+                inputs.emplace_back(g->addTensor({64, 128, 256}, dtype));
+            g->addOp<ConcatObj>(inputs, nullptr, 2);
+            return g;
+        });
+    }
+
+    struct CastCase {
+        DataType from, to;
+        CastType type;
+    };
+    for (auto c : {CastCase{DataType::Float32, DataType::Float16,
+                            CastType::Float2Float16},
+                   CastCase{DataType::Float16, DataType::Float32,
+                            CastType::Float162Float},
+                   CastCase{DataType::Float32, DataType::BFloat16,
+                            CastType::Float2BFloat16},
+                   CastCase{DataType::Float32, DataType::Int8,
+                            CastType::Float2Int8}}) {
+        Shape dims{64, 128, 768};
+        add("Cast", c.from, dimsString(dims) + "->" + c.to.toString(),
+            elements(dims), [=](Runtime runtime) {
+                Graph g = make_ref<GraphObj>(runtime);
+                g->addOp<CastObj>(g->addTensor(dims, c.from), nullptr, c.type);
+                return g;
+            });
+    }
+    return cases;
+}
+
+// Whole graphs, optimized as an application would, for latency percentiles
+vector<Case> graphCases() {
+    vector<Case> cases;
+    for (auto dtype : floatTypes)
+        for (int tokens : {1, 128}) {
+            string dt = dtype.toString();
+            string shape = std::to_string(tokens) + "x768";
+            double flops = 2 * 2.0 * tokens * 768 * 3072;
+            // Transformer feed-forward block with its residual connection
+            cases.push_back(
+                {"FeedForward/" + dt + "/" + shape, "FeedForward", dt, shape,
+                 flops, [=](Runtime runtime) {
+                     Graph g = make_ref<GraphObj>(runtime);
+                     auto x = g->addTensor({tokens, 768}, dtype);
+                     auto w1 = g->addTensor({768, 3072}, dtype);
+                     auto b1 = g->addTensor({3072}, dtype);
+                     auto w2 = g->addTensor({3072, 768}, dtype);
+                     auto b2 = g->addTensor({768}, dtype);
+                     // weights are packed once, when the plan is compiled
+                     for (auto &weight : {w1, b1, w2, b2})
+                         weight->setConstant();
+                     auto h = g->addOp<MatmulObj>(x, w1, nullptr)->getOutput();
+                     h = g->addOp<AddObj>(h, b1, nullptr)->getOutput();
+                     h = g->addOp<ReluObj>(h, nullptr)->getOutput();
+                     h = g->addOp<MatmulObj>(h, w2, nullptr)->getOutput();
+                     h = g->addOp<AddObj>(h, b2, nullptr)->getOutput();
+                     g->addOp<AddObj>(h, x, nullptr);
+                     g->optimize();
+                     return g;
+                 }});
+        }
+    return cases;
+}
+
+void usage(const char *prog) {
+    std::cerr
+        << "usage: " << prog
+        << " [--filter TEXT] [--json FILE] [--min-time SECONDS]\n"
+           "       [--peak-gflops N] [--peak-gbps N] [--list]\n"
+           "Runs the cases whose name contains TEXT and reports throughput\n"
+           "against the machine peaks, which are measured unless given.\n";
+    std::exit(2);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    string filter, jsonPath;
+    double minSeconds = 0.5, peakGflops = 0, peakGbps = 0;
+    bool list = false;
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        auto value = [&]() {
+            if (i + 1 >= argc)
+                usage(argv[0]);
+            return string(argv[++i]);
+        };
+        if (arg == "--filter")
+            filter = value();
+        else if (arg == "--json")
+            jsonPath = value();
+        else if (arg == "--min-time")
+            minSeconds = std::stod(value());
+        else if (arg == "--peak-gflops")
+            peakGflops = std::stod(value());
+        else if (arg == "--peak-gbps")
+            peakGbps = std::stod(value());
+        else if (arg == "--list")
+            list = true;
+        else
+            usage(argv[0]);
+    }
+
+    auto select = [&](vector<Case> cases) {
+        vector<Case> selected;
+        for (auto &c : cases)
+            if (c.name.find(filter) != string::npos)
+                selected.emplace_back(std::move(c));
+        return selected;
+    };
+    auto kernels = select(kernelCases()), graphs = select(graphCases());
+    if (list) {
+        for (const auto &c : kernels)
+            std::cout << c.name << "\n";
+        for (const auto &c : graphs)
+            std::cout << c.name << "\n";
+        return 0;
+    }
+
+    MachinePeak peak;
+    if (peakGflops <= 0 || peakGbps <= 0)
+        peak = measurePeak();
+    if (peakGflops > 0)
+        peak.gflops = peakGflops;
+    if (peakGbps > 0)
+        peak.gbps = peakGbps;
+
+    vector<Result> kernelResults, graphResults;
+    for (const auto &c : kernels) {
+        std::cerr << c.name << "\n";
+        kernelResults.emplace_back(runCase(c, peak, minSeconds));
+    }
+    for (const auto &c : graphs) {
+        std::cerr << c.name << "\n";
+        graphResults.emplace_back(runCase(c, peak, minSeconds));
+    }
+
+    printTable(std::cout, peak, kernelResults, graphResults);
+    if (!jsonPath.empty()) {
+        std::ofstream out(jsonPath);
+        writeJson(out, peak, kernelResults, graphResults);
+        if (!out) {
+            std::cerr << "cannot write " << jsonPath << "\n";
+            return 1;
+        }
+    }
+    return 0;
+}
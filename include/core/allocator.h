@@ -6,20 +6,80 @@
 #endif
 #include <cstddef>
 #include <map>
+#include <ostream>
 #include <unordered_set>
 
 namespace infini {
+  // Lifetime of a memory block in execution steps: it is alive from step
+  // `begin` to step `end`, both inclusive.
+  struct MemoryInterval
+  {
+    size_t size;
+    size_t begin;
+    size_t end;
+    // fuid of the tensor stored in the block, 0 if unknown
+    UidBaseType tensor = 0;
+  };
+
+  // A block placed by Allocator::plan.
+  struct MemoryBlock
+  {
+    UidBaseType tensor;
+    size_t offset;
+    size_t size; // aligned
+    size_t requested;
+    size_t begin, end;
+  };
+
+  struct MemoryStats
+  {
+    size_t used;
+    size_t peak;
+    size_t lowerBound;
+    // bytes asked for, and bytes added to them by rounding up to alignment
+    size_t requested, padding;
+    // Share of the arena below the highest live block that holds no live
+    // block, averaged over the execution steps of the planned blocks. 0 means
+    // the live blocks are always packed at the bottom of the arena.
+    double fragmentation;
+    vector<MemoryBlock> blocks;
+  };
+
+  // How Allocator::plan assigns offsets to a set of lifetime intervals.
+  enum class MemoryPlanStrategy
+  {
+    // replay the intervals through alloc()/free() in execution order
+    FirstFit,
+    // place intervals in execution order into the tightest fitting gap
+    BestFit,
+    // place the largest intervals first, each into the tightest fitting gap
+    GreedyBySize,
+  };
+
   class Allocator
   {
   private:
     Runtime runtime;
 
+    // bytes held by live allocations
     size_t used;
 
+    // high-water mark of the arena, i.e. the size getPtr() really allocates
     size_t peak;
 
+    // maximum bytes simultaneously alive among planned intervals, which no
+    // strategy can go below
+    size_t lowerBound;
+
+    MemoryPlanStrategy strategy;
+
     size_t alignment;
 
+    size_t requested, padding;
+
+    // blocks placed by plan(), in the order of their intervals
+    vector<MemoryBlock> blocks;
+
     // pointer to the memory actually allocated
     void *ptr;
 
@@ -49,6 +109,27 @@ namespace infini {
     //     size: size of memory block to be freed
     void free(size_t addr, size_t size);
 
+    // function: assign offsets to all memory blocks at once from their
+    //           lifetimes, using the current strategy. Each call replaces
+    //           the layout and the statistics of the previous one
+    // arguments:
+    //     intervals: size and lifetime of every memory block
+    // return: head address offset of each memory block
+    vector<size_t> plan(const vector<MemoryInterval> &intervals);
+
+    void setStrategy(MemoryPlanStrategy strategy) { this->strategy = strategy; }
+    MemoryPlanStrategy getStrategy() const { return strategy; }
+    size_t getPeak() const { return peak; }
+    size_t getLowerBound() const { return lowerBound; }
+    MemoryStats getStats() const;
+
+    // function: write the statistics and every planned block as JSON
+    void writeTimeline(std::ostream &os) const;
+
+    // function: draw the arena at each execution step, one row per step and
+    //           `width` columns covering the arena, '#' where a block is live
+    void printLayout(std::ostream &os, size_t width = 64) const;
+
     // function: perform actual memory allocation
     // return: pointer to the head address of the allocated memory
     void *getPtr();
@@ -59,5 +140,15 @@ namespace infini {
     // function: memory alignment, rouned up
     // return: size of the aligned memory block
     size_t getAlignedSize(size_t size);
+
+    // function: alloc() for a size already aligned, without accounting for
+    //           requested bytes
+    size_t allocAligned(size_t size);
+
+    // function: place intervals one by one in the given order, each into the
+    //           smallest gap left by the already placed intervals it overlaps
+    //           in time
+    vector<size_t> planBestFit(const vector<MemoryInterval> &intervals,
+                               const vector<size_t> &order);
   };
 }
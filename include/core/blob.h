@@ -11,15 +11,21 @@ class BlobObj
 {
   Runtime runtime;
   void *ptr;
+  // Keeps external memory, such as a mapped model file, alive for as long as
+  // the blob is bound. Empty for memory in the runtime's arena.
+  Ref<void> owner;
 
 public:
-  BlobObj(Runtime runtime, void *ptr) : runtime(runtime), ptr(ptr) {}
+  BlobObj(Runtime runtime, void *ptr, Ref<void> owner = nullptr)
+      : runtime(runtime), ptr(ptr), owner(std::move(owner)) {}
   BlobObj(BlobObj &other) = delete;
   BlobObj &operator=(BlobObj const &) = delete;
   ~BlobObj() {};
 
   template <typename T>
   T getPtr() const { return reinterpret_cast<T>(ptr); }
+  // External blobs are bound by their owner, not planned by dataMalloc.
+  bool isExternal() const { return owner != nullptr; }
 };
 
 } // namespace infini
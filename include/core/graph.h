@@ -4,6 +4,7 @@
 #include "core/tensor.h"
 #include <algorithm>
 #include <cstdint>
+#include <map>
 #include "operators/transpose.h" 
 #include "operators/matmul.h" 
 namespace infini
@@ -13,36 +14,81 @@ namespace infini
     {
     protected:
         Runtime runtime;
+        // Removing a tensor or an operator leaves a nullptr in its place, so
+        // that removal is O(1) and keeps the order of the others. The holes
+        // are dropped by compact() at the end of a batch of removals.
         TensorVec tensors;
         OpVec ops;
-        Allocator allocator;
+        // positions in `tensors` and `ops`, and tensors by fuid
+        std::unordered_map<TensorObj *, size_t> tensorIndex;
+        std::unordered_map<OperatorObj *, size_t> opIndex;
+        std::unordered_map<UidBaseType, Tensor> fuidIndex;
+        size_t removedTensors = 0, removedOps = 0;
+
+        // The arena for one set of graph input shapes and the offset of every
+        // tensor in it, by position in `tensors` (npos for tensors bound to
+        // external memory).
+        struct MemoryPlan
+        {
+            std::shared_ptr<Allocator> allocator;
+            vector<size_t> offsets;
+            // value of planUses when the plan was last bound
+            size_t lastUse = 0;
+        };
+        // memory plans by the shapes of the graph inputs, dropped whenever
+        // the graph changes; at most maxMemoryPlans are kept, the least
+        // recently bound one is evicted first
+        static constexpr size_t maxMemoryPlans = 4;
+        std::map<vector<Shape>, MemoryPlan> memoryPlans;
+        size_t planUses = 0;
+        // the allocator of the plan the tensors are bound to
+        std::shared_ptr<Allocator> allocator;
+        MemoryPlanStrategy memoryPlanStrategy = MemoryPlanStrategy::FirstFit;
 
     public:
         explicit GraphObj(Runtime runtime)
-            : runtime(runtime), allocator(runtime), sorted(false){};
+            : runtime(runtime), allocator(std::make_shared<Allocator>(runtime)),
+              sorted(false){};
         string toString() const override;
         Runtime getRuntime() const { return runtime; }
 
         Tensor addTensor(Shape dim, DataType dtype = DataType::Float32);
         Tensor addTensor(const Tensor &tensor);
         TensorVec addTensor(const TensorVec &tensors);
-        void removeOperator(Operator op)
+        /**
+         * @brief Remove an operator and its connections to the tensors and
+         * operators around it. Its tensors stay in the graph. Call compact()
+         * after a batch of removals, before the graph is read again.
+         */
+        void removeOperator(Operator op);
+
+        void removeTensor(Tensor tensor);
+
+        /**
+         * @brief Drop the holes left by removals and reindex what moved.
+         * topo_sort, optimize and dataMalloc compact the graph themselves.
+         */
+        void compact();
+
+        const TensorVec &getTensors() const
         {
-            auto it = std::find(ops.begin(), ops.end(), op);
-            if (it != ops.end())
-                ops.erase(it);
+            IT_ASSERT(removedTensors == 0, "Graph has removals to compact");
+            return tensors;
         }
-
-        void removeTensor(Tensor tensor)
+        const OpVec &getOperators() const
         {
-            auto it = std::find(tensors.begin(), tensors.end(), tensor);
-            if (it != tensors.end())
-                tensors.erase(it);
+            IT_ASSERT(removedOps == 0, "Graph has removals to compact");
+            return ops;
         }
-
-        const TensorVec &getTensors() const { return tensors; }
-        const OpVec &getOperators() const { return ops; }
         Tensor getTensor(int) const;
+        bool hasTensor(const Tensor &tensor) const
+        {
+            return tensorIndex.count(tensor.get());
+        }
+        bool hasOperator(const Operator &op) const
+        {
+            return opIndex.count(op.get());
+        }
 
         /**
          * @brief Sort the nodes in topological order.
@@ -52,12 +98,56 @@ namespace infini
          */
         bool topo_sort();
 
+        /**
+         * @brief Rewrite the graph in place: fold the operators that only
+         * read constants, compose, drop and sink transposes, fold transposes
+         * into matmuls and fuse chains of element-wise operators. Constant
+         * tensors must have their data by then, see TensorObj::setConstant.
+         */
         void optimize();
 
         void shape_infer();
 
+        /**
+         * @brief Bind every tensor to memory planned for the current shapes
+         * of the graph inputs. Plans are cached by those shapes, each with an
+         * arena of its own, so planning for shapes seen before only rebinds
+         * the tensors.
+         */
         void dataMalloc();
 
+        /**
+         * @brief Give the graph inputs, in the order of getInputs(), new
+         * shapes, infer the shapes of the other tensors and bind them all to
+         * memory planned for the new shapes, see dataMalloc. The tensors move
+         * to that memory, so the inputs must be set again. An ExecutionPlan
+         * compiled for some shapes may be kept and run again whenever those
+         * shapes are current, until the graph is changed or the plan for
+         * those shapes is evicted from the cache of the last few shapes.
+         */
+        void setInputShapes(const vector<Shape> &shapes);
+
+        /**
+         * @brief Select how dataMalloc packs tensors into the memory arena.
+         * Takes effect for the shapes planned from now on.
+         */
+        void setMemoryPlanStrategy(MemoryPlanStrategy strategy)
+        {
+            memoryPlanStrategy = strategy;
+            memoryPlans.clear();
+        }
+
+        /**
+         * @brief The allocator that packed the tensors for the current
+         * shapes, for memory statistics and the arena timeline after
+         * dataMalloc.
+         */
+        const Allocator &getAllocator() const { return *allocator; }
+        std::shared_ptr<const Allocator> shareAllocator() const
+        {
+            return allocator;
+        }
+
         /**
          * @brief Add an operator and create its outputs. Output tensor arguments
          * should be empty Refs (e.g., nullptr).
@@ -82,13 +172,13 @@ namespace infini
         }
 
         /**
-         * @brief Gets input tensors of this graph.
+         * @brief Gets input tensors of this graph, the constants aside.
          */
         inline TensorVec getInputs() const
         {
             TensorVec ret;
-            for (const auto &t : tensors)
-                if (!t->getSource())
+            for (const auto &t : getTensors())
+                if (!t->getSource() && !t->isConstant())
                     ret.emplace_back(t);
             return ret;
         }
@@ -99,7 +189,7 @@ namespace infini
         inline TensorVec getOutputs() const
         {
             TensorVec ret;
-            for (const auto &t : tensors)
+            for (const auto &t : getTensors())
                 if (t->getTargets().empty())
                     ret.emplace_back(t);
             return ret;
@@ -113,6 +203,31 @@ namespace infini
          */
         void addOperatorAndConnect(const Operator &op);
 
+        /**
+         * @brief Make op read newInput in place of oldInput, keeping the
+         * graph connections consistent.
+         */
+        void replaceInput(const Operator &op, const Tensor &oldInput,
+                          const Tensor &newInput);
+
+        /**
+         * @brief Concat inputs that can be produced in place in the concat
+         * output, mapped to the output and their byte offset in it.
+         */
+        std::unordered_map<TensorObj *, pair<TensorObj *, size_t>>
+        planConcatAliases() const;
+
+        /**
+         * @brief Plan the memory of the tensors for their current shapes.
+         */
+        MemoryPlan planMemory() const;
+
+        void foldConstants();
+        void canonicalizeTransposes();
+        void foldTransposeIntoMatmul();
+        void fuseMatmulEpilogue();
+        void fuseElementWise();
+
         /**
          * @brief If the nodes is sorted in topological order.
          */
@@ -0,0 +1,24 @@
+#pragma once
+#include "core/graph.h"
+#include <unordered_map>
+
+namespace infini
+{
+    /**
+     * @brief Export the topology and attributes of a graph as JSON. Tensors
+     * are listed with an id, their dims and data type; the ones in `weights`
+     * carry the given name instead of data, e.g. a key into weights stored
+     * with saveGraph or elsewhere. Only built with nlohmann_json (USE_JSON).
+     */
+    string graphToJson(const Graph &graph,
+                       const std::unordered_map<Tensor, string> &weights = {});
+
+    /**
+     * @brief Build a graph from the JSON of graphToJson, which may have been
+     * edited by hand. The tensors that name a weight are returned in
+     * `weights` by name, to be bound before or after dataMalloc.
+     */
+    Graph graphFromJson(Runtime runtime, const string &json,
+                        std::unordered_map<string, Tensor> *weights = nullptr);
+
+} // namespace infini
@@ -21,6 +21,20 @@ namespace infini
          */
         virtual void compute(const Operator &op,
                              const RuntimeObj *context) const = 0;
+
+        /**
+         * @brief Resolves everything an execution of the op needs (data type
+         * dispatch, raw data pointers and shape-derived constants) and returns
+         * a closure that only does the computation. The tensors must already
+         * be bound to memory and keep it while the closure is used. The
+         * default falls back to calling compute().
+         */
+        virtual KernelFunc prepare(const Operator &op,
+                                   const RuntimeObj *context) const
+        {
+            return [this, op, context]()
+            { compute(op, context); };
+        }
     };
 
     class KernelRegistry
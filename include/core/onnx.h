@@ -0,0 +1,23 @@
+#pragma once
+#include "core/graph.h"
+#include <unordered_map>
+
+namespace infini
+{
+    /**
+     * @brief Import an ONNX model. Supported operators are Add, Sub, Mul,
+     * Div, MatMul, Gemm (alpha = beta = 1), Relu, Clip, Cast, Concat and
+     * Transpose, plus Constant and Identity which are resolved while
+     * importing; any other operator fails the import with a list of all the
+     * unsupported ones. The model and any external data files are mapped and
+     * initializers stored as suitably aligned raw data are bound to their
+     * bytes in the mapping without copying.
+     *
+     * @param tensors If set, receives the tensors of the graph by ONNX name.
+     * @param dimValues Values of symbolic input dims, such as "batch".
+     */
+    Graph loadOnnx(Runtime runtime, const string &path,
+                   std::unordered_map<string, Tensor> *tensors = nullptr,
+                   const std::unordered_map<string, int> &dimValues = {});
+
+} // namespace infini
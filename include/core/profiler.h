@@ -0,0 +1,85 @@
+#pragma once
+#include "core/operator.h"
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <thread>
+#include <unordered_map>
+
+namespace infini
+{
+    /**
+     * @brief Records the execution of every operator run by a runtime it is
+     * attached to, see NativeCpuRuntimeObj::setProfiler. Records can be
+     * aggregated by operator type and kernel, or exported as Chrome
+     * trace-event JSON (chrome://tracing, Perfetto). Recording is thread-safe,
+     * so plans run by inter-op workers can be profiled too. A profiler must
+     * be owned by a shared_ptr: the launches it wraps keep it alive.
+     */
+    class Profiler : public std::enable_shared_from_this<Profiler>
+    {
+    public:
+        struct Record
+        {
+            UidBaseType guid; // of the operator
+            OpType type;
+            string kernel;
+            // nanoseconds since the profiler was created or cleared
+            int64_t begin, duration;
+            double flops, bytes;
+            int thread; // in the order threads first recorded
+        };
+
+        struct Summary
+        {
+            OpType type;
+            string kernel;
+            size_t calls;
+            double seconds, flops, bytes;
+        };
+
+    private:
+        using Clock = std::chrono::steady_clock;
+
+        mutable std::mutex mutex;
+        Clock::time_point origin;
+        vector<Record> records;
+        std::unordered_map<std::thread::id, int> threads;
+
+    public:
+        Profiler() : origin(Clock::now()) {}
+
+        /**
+         * @brief Wrap the launch of `op` so that each call is recorded. The
+         * cost model of the op is evaluated here, once. The wrapped launch
+         * holds a reference to the profiler, so plans compiled with it can
+         * still be run after it was detached from the runtime.
+         */
+        KernelFunc wrap(const Operator &op, const string &kernel,
+                        KernelFunc launch);
+
+        vector<Record> getRecords() const;
+        /**
+         * @brief Totals by operator type and kernel, the most expensive first.
+         */
+        vector<Summary> summarize() const;
+        void clear();
+
+        void printSummary(std::ostream &os) const;
+        void writeChromeTrace(std::ostream &os) const;
+        void saveChromeTrace(const string &path) const;
+
+        /**
+         * @brief Arithmetic operations of one execution of `op`. Data
+         * movement such as Transpose, Concat and Cast counts as 0.
+         */
+        static double countFlops(const Operator &op);
+        /**
+         * @brief Bytes of one execution of `op`: every input read and every
+         * output written once.
+         */
+        static double countBytes(const Operator &op);
+    };
+
+} // namespace infini
@@ -10,6 +10,7 @@ namespace infini
   class GraphObj;
   class RuntimeObj;
   class BlobObj;
+  class Allocator;
 
   using Tensor = Ref<TensorObj>;
   using Operator = Ref<OperatorObj>;
@@ -25,6 +26,30 @@ namespace infini
     CPU = 1
   };
 
+  // A prepared kernel launch, see Kernel::prepare.
+  using KernelFunc = std::function<void()>;
+
+  /**
+   * @brief A graph compiled for repeated execution: one prepared launch per
+   * operator in topological order. Launches refer to the raw data pointers
+   * the tensors were bound to when the plan was compiled.
+   */
+  struct ExecutionPlan
+  {
+    vector<KernelFunc> launches;
+    // successors[i]: launches that may only start after launch i finished,
+    // either because they read its outputs or because they reuse the memory
+    // of a tensor launch i reads or writes.
+    vector<vector<size_t>> successors;
+    // number of launches each launch waits for
+    vector<int> dependencies;
+    // the arena the launches point into, kept alive with the plan
+    std::shared_ptr<const Allocator> memory;
+  };
+
+  class ThreadPool;
+  class Profiler;
+
   class RuntimeObj : public std::enable_shared_from_this<RuntimeObj>
   {
   protected:
@@ -38,6 +63,12 @@ namespace infini
     virtual ~RuntimeObj() {}
 
     virtual void run(const Graph &graph) const = 0;
+    /**
+     * @brief Resolve the kernel of every operator once. The graph must be
+     * topologically sorted and its data allocated.
+     */
+    virtual ExecutionPlan compile(const Graph &graph) const = 0;
+    virtual void run(const ExecutionPlan &plan) const = 0;
     virtual void *alloc(size_t size) = 0;
     virtual void dealloc(void *ptr) = 0;
 
@@ -51,6 +82,12 @@ namespace infini
 
   class NativeCpuRuntimeObj : public RuntimeObj
   {
+    // workers running independent launches of a plan concurrently, or
+    // nullptr to run plans one launch after another
+    std::shared_ptr<ThreadPool> interOpPool;
+    // records the launches when set, see setProfiler
+    std::shared_ptr<Profiler> profiler;
+
   public:
     NativeCpuRuntimeObj() : RuntimeObj(Device::CPU) {}
 
@@ -62,6 +99,25 @@ namespace infini
     }
     void dealloc(void *ptr) override;
     void run(const Graph &graph) const override;
+    ExecutionPlan compile(const Graph &graph) const override;
+    void run(const ExecutionPlan &plan) const override;
+    /**
+     * @brief Run independent operators of a plan concurrently on `numWorkers`
+     * threads. The OpenMP threads available to the calling thread are split
+     * evenly among the workers, so that inter-op and intra-op parallelism
+     * together do not oversubscribe the cores. numWorkers <= 1 restores
+     * sequential execution.
+     */
+    void setInterOpThreads(int numWorkers);
+    int getInterOpThreads() const;
+    /**
+     * @brief Record every operator run from now on into `profiler`, or stop
+     * profiling with nullptr. A plan records into the profiler that was set
+     * when it was compiled; plans compiled without one run the bare launches
+     * and pay nothing for profiling.
+     */
+    void setProfiler(std::shared_ptr<Profiler> profiler);
+    const std::shared_ptr<Profiler> &getProfiler() const { return profiler; }
     void *alloc(size_t size) override;
     string toString() const override;
   };
@@ -0,0 +1,22 @@
+#pragma once
+#include "core/graph.h"
+
+namespace infini
+{
+    /**
+     * @brief Save a graph to a binary model file: the tensors with their
+     * shapes and data types, the operators in topological order with their
+     * attributes, and the data of `weights`, each blob aligned to 64 bytes.
+     */
+    void saveGraph(const Graph &graph, const string &path,
+                   const TensorVec &weights);
+
+    /**
+     * @brief Load a model file saved by saveGraph. The file is mapped and the
+     * weight tensors are bound to their blobs in the mapping, so they are not
+     * copied and dataMalloc leaves them out of the arena. Pages are read on
+     * first use and the mapping lives as long as any weight tensor.
+     */
+    Graph loadGraph(Runtime runtime, const string &path);
+
+} // namespace infini
@@ -24,6 +24,7 @@ namespace infini
         WRef<OperatorObj> source;
         Blob data;
         Runtime runtime;
+        bool constant = false;
 
     private:
         Shape shape;
@@ -49,6 +50,16 @@ namespace infini
 
         void setDataBlob(const Blob &blob);
 
+        /**
+         * @brief Mark the tensor as a constant, such as a weight. A tensor not
+         * bound to external memory gets memory of its own, outside the arena,
+         * so its data can be set before the graph is optimized: optimize
+         * folds the operators that only read constants, and MatMul packs a
+         * constant B when it is compiled. The data must not change afterwards.
+         */
+        void setConstant();
+        bool isConstant() const { return constant; }
+
         void printData() const;
         bool equalData(const Tensor &rhs, double relativeError = 1e-6) const;
 
@@ -0,0 +1,55 @@
+#pragma once
+#include "core/operator.h"
+
+namespace infini
+{
+  /**
+   * @brief A chain of element-wise and unary operators evaluated in a single
+   * pass over the output. Built by GraphObj::optimize from producer-consumer
+   * chains of Add/Sub/Mul/Div/Relu/Clip, so that intermediates never reach
+   * memory.
+   *
+   */
+  class FusedElementWiseObj : public OperatorObj
+  {
+  public:
+    /**
+     * @brief One operator of the chain. An operand >= 0 is an index into the
+     * inputs of the fused operator, an operand < 0 refers to the result of an
+     * earlier step (see stepOperand). The last step produces the output, and
+     * every step has the shape of the output.
+     */
+    struct Step
+    {
+      OpType type;
+      int lhs, rhs; // rhs is unused by unary steps
+      std::optional<float> min, max; // Clip only
+    };
+
+    /**
+     * @brief Construct a new FusedElementWise object.
+     *
+     * @param graph The computation graph that this operator belongs to.
+     * @param inputs The tensors read by the steps.
+     * @param output The output tensor.
+     * @param steps The operators in evaluation order.
+     */
+    FusedElementWiseObj(GraphObj *graph, TensorVec inputs, Tensor output,
+                        vector<Step> steps);
+    OP_CLONE(FusedElementWiseObj);
+    optional<vector<Shape>> inferShape(const TensorVec &inputs) override;
+
+    std::string toString() const override;
+    int numInputs() const override { return inputs.size(); }
+    int numOutputs() const override { return 1; }
+    const vector<Step> &getSteps() const { return steps; }
+
+    static int stepOperand(size_t step) { return -1 - (int)step; }
+    static size_t operandStep(int operand) { return -1 - operand; }
+    // Whether an operator can be a part of a fused chain
+    static bool isFusible(OpType type);
+
+  private:
+    vector<Step> steps;
+  };
+}; // namespace infini
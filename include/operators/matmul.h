@@ -3,6 +3,24 @@
 
 namespace infini
 {
+    /**
+     * @brief Quantization of a matmul, where real = scale * (q - zeroPoint).
+     */
+    struct MatmulQuantization
+    {
+        // A is UInt8 with a per-tensor scale and zero point.
+        float scaleA = 1.f;
+        int32_t zeroA = 0;
+        // B is Int8 and symmetric, with a single scale or one per output
+        // column (channel).
+        vector<float> scaleB = {1.f};
+        // Float32 outputs the dequantized result. UInt8 and Int8 requantize
+        // it with scaleC and zeroC.
+        DataType outType = DataType::Float32;
+        float scaleC = 1.f;
+        int32_t zeroC = 0;
+    };
+
     /**
      * @brief Matrix multiplication.
      *
@@ -15,6 +33,15 @@ namespace infini
         // oppsite to the column-major BLAS.
         bool transA, transB;
 
+        // Epilogue applied to C before it is stored: C = clamp(A * B + bias,
+        // minValue, maxValue). The bias is the optional third input and is
+        // broadcast to C. Relu is expressed as minValue = 0.
+        std::optional<float> minValue, maxValue;
+
+        // Set for a uint8 x int8 matmul accumulated in int32. The bias and
+        // the clamp then apply to the dequantized result.
+        std::optional<MatmulQuantization> quant;
+
         // Auxiliary attributes which are not a part of operator attributes.
         int m, n, k;
 
@@ -37,13 +64,18 @@ namespace infini
          * the constructor, C should be an empty Ref.
          * @param transA If matrix A should be transposed when computing.
          * @param transB If matrix B should be transposed when computing.
+         * @param bias Optional tensor added to C, broadcast to its shape.
+         * @param quant Scales and zero points if A and B are quantized.
          */
         MatmulObj(GraphObj *graph, Tensor A, Tensor B, Tensor C,
-                  bool transA = false, bool transB = false);
+                  bool transA = false, bool transB = false,
+                  Tensor bias = nullptr,
+                  std::optional<MatmulQuantization> quant = std::nullopt);
         OP_CLONE(MatmulObj);
 
         std::string toString() const override;
         optional<vector<Shape>> inferShape(const TensorVec &inputs) override;
+        vector<DataType> inferDataType(const TensorVec &inputs) const override;
 
         int numInputs() const override { return inputs.size(); }
         int numOutputs() const override { return 1; }
@@ -52,6 +84,18 @@ namespace infini
         bool getTransB() const { return transB; }
         void setTransA(bool transA) { this->transA = transA; }
         void setTransB(bool transB) { this->transB = transB; }
+        Tensor getBias() const { return inputs.size() > 2 ? inputs[2] : nullptr; }
+        std::optional<float> getMin() const { return minValue; }
+        std::optional<float> getMax() const { return maxValue; }
+        const std::optional<MatmulQuantization> &getQuantization() const
+        {
+            return quant;
+        }
+        /**
+         * @brief Clamp the output to [min, max] after any clamp already in
+         * the epilogue, i.e. fold a following Relu or Clip into the matmul.
+         */
+        void clampOutput(std::optional<float> min, std::optional<float> max);
         int getM() const { return m; }
         int getN() const { return n; }
         int getK() const { return k; }
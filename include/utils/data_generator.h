@@ -1,5 +1,6 @@
 #pragma once
 #include "core/common.h"
+#include "utils/half.h"
 #include <random>
 
 namespace infini {
@@ -16,6 +17,17 @@ public:
             fill(reinterpret_cast<uint32_t *>(data), size);
         else if (dataType == DataType::Float32)
             fill(reinterpret_cast<float *>(data), size);
+        else if (dataType == DataType::Float16 ||
+                 dataType == DataType::BFloat16) {
+            // Generated in fp32 and rounded to the storage format
+            vector<float> values(size);
+            fill(values.data(), size);
+            auto dst = reinterpret_cast<uint16_t *>(data);
+            if (dataType == DataType::Float16)
+                fp32ToFp16(values.data(), dst, size);
+            else
+                fp32ToBf16(values.data(), dst, size);
+        }
         else
             IT_TODO_HALT();
     }
@@ -0,0 +1,75 @@
+#pragma once
+#ifndef GEMM_H
+#define GEMM_H
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace infini {
+
+// Work applied to each tile of C right after its last update, while the tile
+// is still in cache: C[i][j] = clamp(C[i][j] + bias[i * biasRowStride +
+// j * biasColStride], lo, hi). biasColStride must be 0 or 1.
+struct GemmEpilogue {
+    const float *bias = nullptr;
+    size_t biasRowStride = 0, biasColStride = 0;
+    float lo = -std::numeric_limits<float>::infinity();
+    float hi = std::numeric_limits<float>::infinity();
+};
+
+// Single precision GEMM on row-major matrices: C = op(A) * op(B), where op(A)
+// is m x k and op(B) is k x n. `lda`/`ldb`/`ldc` are the row strides of the
+// matrices as they are stored, i.e. A is stored as k x m when transA is set.
+// Panels of A and B are packed into cache-sized blocks and multiplied by an
+// AVX2/FMA micro-kernel when the CPU supports it, or a portable one otherwise.
+void sgemm(bool transA, bool transB, int m, int n, int k, const float *A,
+           size_t lda, const float *B, size_t ldb, float *C, size_t ldc,
+           const GemmEpilogue *epilogue = nullptr);
+
+// The same with A and B stored as IEEE half (hgemm) or bfloat16 (bf16gemm)
+// bit patterns. Operands are widened to fp32 as they are packed, so the
+// products accumulate in fp32 and C is fp32.
+void hgemm(bool transA, bool transB, int m, int n, int k, const uint16_t *A,
+           size_t lda, const uint16_t *B, size_t ldb, float *C, size_t ldc,
+           const GemmEpilogue *epilogue = nullptr);
+void bf16gemm(bool transA, bool transB, int m, int n, int k,
+              const uint16_t *A, size_t lda, const uint16_t *B, size_t ldb,
+              float *C, size_t ldc, const GemmEpilogue *epilogue = nullptr);
+
+// op(B) packed ahead of time into the panels the GEMMs above multiply from,
+// for a B that is multiplied many times, such as a weight. Packing widens to
+// fp32 whatever the storage of B, so only the packing differs by type.
+struct GemmPackedB {
+    int k = 0, n = 0;
+    std::vector<float> data;
+};
+
+GemmPackedB sgemmPackB(bool transB, int k, int n, const float *B, size_t ldb);
+GemmPackedB hgemmPackB(bool transB, int k, int n, const uint16_t *B,
+                       size_t ldb);
+GemmPackedB bf16gemmPackB(bool transB, int k, int n, const uint16_t *B,
+                          size_t ldb);
+
+// C = op(A) * B for a packed B; k and n are those B was packed with.
+void sgemmPacked(bool transA, int m, const float *A, size_t lda,
+                 const GemmPackedB &B, float *C, size_t ldc,
+                 const GemmEpilogue *epilogue = nullptr);
+void hgemmPacked(bool transA, int m, const uint16_t *A, size_t lda,
+                 const GemmPackedB &B, float *C, size_t ldc,
+                 const GemmEpilogue *epilogue = nullptr);
+void bf16gemmPacked(bool transA, int m, const uint16_t *A, size_t lda,
+                    const GemmPackedB &B, float *C, size_t ldc,
+                    const GemmEpilogue *epilogue = nullptr);
+
+// Integer GEMM for quantized matmul: C = op(A) * op(B) with A uint8, B int8
+// and C accumulated exactly in int32. Zero points are left to the caller.
+// Operands are packed in groups along k and multiplied with VNNI vpdpbusd
+// or, widened to int16, with AVX2 vpmaddwd when the CPU supports them.
+void igemm(bool transA, bool transB, int m, int n, int k, const uint8_t *A,
+           size_t lda, const int8_t *B, size_t ldb, int32_t *C, size_t ldc);
+
+} // namespace infini
+
+#endif
@@ -0,0 +1,114 @@
+#pragma once
+#ifndef HALF_H
+#define HALF_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace infini {
+
+// IEEE half and bfloat16 values are stored as uint16_t bit patterns (see
+// DT<10> and DT<16>). Conversions from float round to nearest even.
+
+inline uint32_t floatBits(float val) {
+    uint32_t bits;
+    std::memcpy(&bits, &val, sizeof(bits));
+    return bits;
+}
+
+inline float bitsFloat(uint32_t bits) {
+    float val;
+    std::memcpy(&val, &bits, sizeof(val));
+    return val;
+}
+
+inline float fp16ToFp32(uint16_t h) {
+    uint32_t sign = uint32_t(h & 0x8000) << 16;
+    uint32_t exp = (h >> 10) & 0x1f, mant = h & 0x3ff;
+    if (exp == 0x1f) // inf or nan
+        return bitsFloat(sign | 0x7f800000 | mant << 13);
+    if (exp == 0) {
+        // zero or subnormal: mant * 2^-24
+        float val = float(mant) * bitsFloat(0x33800000);
+        return sign ? -val : val;
+    }
+    return bitsFloat(sign | (exp + 112) << 23 | mant << 13);
+}
+
+inline uint16_t fp32ToFp16(float val) {
+    uint32_t bits = floatBits(val);
+    uint16_t sign = (bits >> 16) & 0x8000;
+    uint32_t abs = bits & 0x7fffffff;
+    if (abs > 0x7f800000) // nan, kept quiet
+        return sign | 0x7e00 | ((abs >> 13) & 0x3ff);
+    if (abs >= 0x477ff000) // rounds to or beyond infinity
+        return sign | 0x7c00;
+    if (abs < 0x38800000) {
+        // subnormal half: adding 0.5 aligns the mantissa at 2^-24 and lets
+        // the FPU do the rounding
+        float f = bitsFloat(abs) + 0.5f;
+        return sign | uint16_t(floatBits(f) - 0x3f000000);
+    }
+    uint32_t odd = (abs >> 13) & 1;
+    abs += 0xc8000fff + odd; // rebias exponent and round to nearest even
+    return sign | uint16_t(abs >> 13);
+}
+
+inline float bf16ToFp32(uint16_t h) { return bitsFloat(uint32_t(h) << 16); }
+
+inline uint16_t fp32ToBf16(float val) {
+    uint32_t bits = floatBits(val);
+    if ((bits & 0x7fffffff) > 0x7f800000) // nan, kept quiet
+        return uint16_t(bits >> 16) | 0x40;
+    bits += 0x7fff + ((bits >> 16) & 1);
+    return uint16_t(bits >> 16);
+}
+
+// Bulk conversions, using F16C/AVX2 when the CPU supports them.
+void fp16ToFp32(const uint16_t *src, float *dst, size_t n);
+void fp32ToFp16(const float *src, uint16_t *dst, size_t n);
+void bf16ToFp32(const uint16_t *src, float *dst, size_t n);
+void fp32ToBf16(const float *src, uint16_t *dst, size_t n);
+
+// Reduced-precision storage formats. Values are loaded into fp32 for compute
+// and stored back rounded, so kernels only need fp32 arithmetic.
+struct Float16Storage {
+    static float load(uint16_t val) { return fp16ToFp32(val); }
+    static uint16_t store(float val) { return fp32ToFp16(val); }
+    static void load(const uint16_t *src, float *dst, size_t n) {
+        fp16ToFp32(src, dst, n);
+    }
+    static void store(const float *src, uint16_t *dst, size_t n) {
+        fp32ToFp16(src, dst, n);
+    }
+};
+
+struct BFloat16Storage {
+    static float load(uint16_t val) { return bf16ToFp32(val); }
+    static uint16_t store(float val) { return fp32ToBf16(val); }
+    static void load(const uint16_t *src, float *dst, size_t n) {
+        bf16ToFp32(src, dst, n);
+    }
+    static void store(const float *src, uint16_t *dst, size_t n) {
+        fp32ToBf16(src, dst, n);
+    }
+};
+
+// Run `f(const float *in, float *out, size_t n)` over src in fp32 blocks
+// small enough to stay in L1, storing the results to dst.
+template <typename Storage, typename F>
+void mapFp32(const uint16_t *src, uint16_t *dst, size_t n, F &&f) {
+    constexpr size_t block = 256;
+    float in[block], out[block];
+    for (size_t i = 0; i < n; i += block) {
+        size_t len = n - i < block ? n - i : block;
+        Storage::load(src + i, in, len);
+        f(in, out, len);
+        Storage::store(out, dst + i, len);
+    }
+}
+
+} // namespace infini
+
+#endif
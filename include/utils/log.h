@@ -0,0 +1,51 @@
+#pragma once
+#ifndef LOG_H
+#define LOG_H
+
+#include <atomic>
+#include <sstream>
+#include <string>
+
+namespace infini {
+
+enum class LogLevel { Debug, Info, Warning, Error, Off };
+
+// Messages below the log level are dropped without being formatted. The
+// level defaults to Warning and can be set with the INFINI_LOG_LEVEL
+// environment variable (debug, info, warning, error or off).
+LogLevel getLogLevel();
+void setLogLevel(LogLevel level);
+
+namespace detail {
+// set and read from any thread, e.g. the workers of a parallel plan
+extern std::atomic<LogLevel> logLevel;
+
+// Collects one message and writes it to stderr when destroyed.
+class LogMessage {
+    std::ostringstream os;
+
+  public:
+    LogMessage(LogLevel level, const char *file, int line);
+    ~LogMessage();
+    std::ostream &stream() { return os; }
+};
+} // namespace detail
+
+inline bool logEnabled(LogLevel level) {
+    return level < LogLevel::Off &&
+           level >= detail::logLevel.load(std::memory_order_relaxed);
+}
+
+} // namespace infini
+
+// IT_LOG(Info) << "message"; the operands are only evaluated if Info is
+// enabled.
+#define IT_LOG(level)                                                          \
+    if (!::infini::logEnabled(::infini::LogLevel::level))                      \
+        ;                                                                      \
+    else                                                                       \
+        ::infini::detail::LogMessage(::infini::LogLevel::level, __FILE__,      \
+                                     __LINE__)                                 \
+            .stream()
+
+#endif
@@ -0,0 +1,29 @@
+#pragma once
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <string>
+
+namespace infini {
+
+// A whole file mapped into memory. Pages are loaded on first access and the
+// mapping is private, so writes through data() stay in this process and never
+// reach the file.
+class MappedFile {
+    char *addr = nullptr;
+    size_t bytes = 0;
+
+  public:
+    explicit MappedFile(const std::string &path);
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+    ~MappedFile();
+
+    char *data() const { return addr; }
+    size_t size() const { return bytes; }
+};
+
+} // namespace infini
+
+#endif
@@ -18,6 +18,18 @@ Shape locate_index(size_t inputN, const Shape &shape);
 // Delocate the ShapeIndex from Shape with broadcast
 size_t delocate_index(const Shape &shapeIndex, const Shape &shape,
                       const Shape &stride);
+// Iteration space of a broadcast op: the output dims with every size-1 dim
+// dropped and neighbouring dims merged when all inputs broadcast them the
+// same way. strides[i] holds the element strides of input i along each
+// collapsed dim (0 where the input is broadcast), so the innermost stride of
+// every input is 0 or 1.
+struct BroadcastLayout {
+    vector<size_t> dims;
+    vector<vector<size_t>> strides;
+};
+// Collapse the broadcast of the inputs to output, see BroadcastLayout
+BroadcastLayout collapse_broadcast(const vector<Shape> &inputs,
+                                   const Shape &output);
 // Convert KernelAttrs to a string representation
 std::string get_kernel_attrs_str(const KernelAttrs &kernelAttrs);
 
@@ -0,0 +1,99 @@
+#pragma once
+#ifndef PROTOBUF_H
+#define PROTOBUF_H
+
+#include "core/common.h"
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+namespace infini {
+
+// Reader of the protobuf wire format, enough to walk messages such as ONNX
+// models without generated code. Length-delimited fields are returned as
+// views into the buffer, so nothing is copied.
+class ProtoReader {
+    const uint8_t *ptr, *end;
+    uint32_t wireType = 0;
+
+  public:
+    enum WireType : uint32_t { Varint = 0, Fixed64 = 1, Bytes = 2, Fixed32 = 5 };
+
+    ProtoReader(const void *data, size_t size)
+        : ptr(static_cast<const uint8_t *>(data)), end(ptr + size) {}
+    explicit ProtoReader(std::string_view bytes)
+        : ProtoReader(bytes.data(), bytes.size()) {}
+
+    // Move to the next field and return its number, or 0 at the end.
+    uint32_t next() {
+        if (ptr == end)
+            return 0;
+        uint64_t key = varint();
+        wireType = key & 7;
+        IT_ASSERT((key >> 3) > 0, "Bad protobuf field");
+        return key >> 3;
+    }
+    uint32_t type() const { return wireType; }
+
+    uint64_t varint() {
+        uint64_t val = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            IT_ASSERT(ptr < end, "Truncated protobuf");
+            uint8_t byte = *ptr++;
+            val |= uint64_t(byte & 0x7f) << shift;
+            if (!(byte & 0x80))
+                return val;
+        }
+        IT_TODO_HALT_MSG("Bad protobuf varint");
+    }
+    int64_t int64() { return int64_t(varint()); }
+    template <typename T> T fixed() {
+        IT_ASSERT(size_t(end - ptr) >= sizeof(T), "Truncated protobuf");
+        T val;
+        std::memcpy(&val, ptr, sizeof(T));
+        ptr += sizeof(T);
+        return val;
+    }
+    std::string_view bytes() {
+        uint64_t len = varint();
+        IT_ASSERT(len <= uint64_t(end - ptr), "Truncated protobuf");
+        std::string_view view(reinterpret_cast<const char *>(ptr), len);
+        ptr += len;
+        return view;
+    }
+    void skip() {
+        switch (wireType) {
+        case Varint:
+            varint();
+            break;
+        case Fixed64:
+            fixed<uint64_t>();
+            break;
+        case Bytes:
+            bytes();
+            break;
+        case Fixed32:
+            fixed<uint32_t>();
+            break;
+        default:
+            IT_TODO_HALT_MSG("Unsupported protobuf wire type " +
+                             std::to_string(wireType));
+        }
+    }
+
+    // A repeated scalar field, which may be packed (one Bytes field) or not
+    // (one field per element). Calls f with each value read by `read`.
+    template <typename Read, typename F> void repeated(Read read, F &&f) {
+        if (wireType != Bytes) {
+            f(read(*this));
+            return;
+        }
+        ProtoReader packed(bytes());
+        while (packed.ptr < packed.end)
+            f(read(packed));
+    }
+};
+
+} // namespace infini
+
+#endif
@@ -0,0 +1,34 @@
+#pragma once
+#ifndef QUANTIZE_H
+#define QUANTIZE_H
+
+#include "core/tensor.h"
+
+namespace infini {
+
+// Affine quantization: real = scale * (q - zeroPoint).
+struct QuantParams {
+    float scale = 1.f;
+    int32_t zeroPoint = 0;
+};
+
+// Asymmetric uint8 parameters covering the range of Float32 sample tensors,
+// e.g. the activations a matmul sees over a calibration set. The range is
+// widened to include 0 so that zero is represented exactly.
+QuantParams calibrateUInt8(const TensorVec &samples);
+// Symmetric int8 scales for the Float32 weight B of a matmul: one per output
+// column of op(B) when perChannel is set, a single one otherwise.
+vector<float> calibrateInt8(const Tensor &weight, bool transB,
+                            bool perChannel = true);
+
+// Quantize Float32 src into the UInt8 tensor dst, rounding to nearest and
+// saturating.
+void quantizeUInt8(const Tensor &src, const Tensor &dst, QuantParams params);
+// Quantize the Float32 weight into the Int8 tensor dst with the scales of
+// calibrateInt8.
+void quantizeInt8(const Tensor &weight, const Tensor &dst,
+                  const vector<float> &scales, bool transB);
+
+} // namespace infini
+
+#endif
@@ -0,0 +1,55 @@
+#pragma once
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace infini {
+
+// Work-stealing thread pool. Each worker owns a task deque: tasks submitted
+// from a worker go to the back of its own deque and are popped LIFO, idle
+// workers steal from the front of the others. Each worker runs its OpenMP
+// parallel regions with `intraOpThreads` threads.
+class ThreadPool {
+  public:
+    using Task = std::function<void()>;
+
+    ThreadPool(int numWorkers, int intraOpThreads);
+    ~ThreadPool();
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    void submit(Task task);
+    int size() const { return workers.size(); }
+    int getIntraOpThreads() const { return intraOpThreads; }
+
+  private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    void workerLoop(int index);
+    bool tryPop(int index, Task &task);
+
+    int intraOpThreads;
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> workers;
+    // Tasks submitted but not yet picked up, to let idle workers sleep.
+    std::atomic<size_t> queued{0};
+    std::atomic<size_t> nextQueue{0};
+    std::atomic<bool> stop{false};
+    std::mutex sleepMutex;
+    std::condition_variable wakeUp;
+};
+
+} // namespace infini
+
+#endif
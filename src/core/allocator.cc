@@ -1,4 +1,9 @@
 #include "core/allocator.h"
+#include "utils/log.h"
+#include <algorithm>
+#include <cstdint>
+#include <iomanip>
+#include <numeric>
 #include <utility>
 
 namespace infini
@@ -7,6 +12,10 @@ namespace infini
     {
         used = 0;
         peak = 0;
+        lowerBound = 0;
+        requested = 0;
+        padding = 0;
+        strategy = MemoryPlanStrategy::FirstFit;
         ptr = nullptr;
         heapEnd = 0;
         // 'alignment' defaults to sizeof(uint64_t), because it is the length of
@@ -27,7 +36,14 @@ namespace infini
     {
         IT_ASSERT(this->ptr == nullptr);
         // pad the size to the multiple of alignment
-        size = this->getAlignedSize(size);
+        size_t aligned = this->getAlignedSize(size);
+        requested += size;
+        padding += aligned - size;
+        return allocAligned(aligned);
+    }
+
+    size_t Allocator::allocAligned(size_t size)
+    {
 
         // =================================== 作业 ===================================
         // TODO: 设计一个算法来分配内存，返回起始地址偏移量
@@ -46,16 +62,25 @@ namespace infini
                 }
 
                 used += size;
-                peak = std::max(peak, used);
                 return addr;
             }
         }
-        printf("when allocate memory,there is an action requesting new memory\n");
+        IT_LOG(Debug) << "No free block fits " << size
+                      << " bytes, growing the arena from " << heapEnd;
         // 第二阶段：没有可用空闲块，从堆末端分配
+        // 若最后一个空闲块紧邻堆末端，则将其与新扩展的部分合并使用
+        if (!freeBlocks.empty()) {
+            auto last = std::prev(freeBlocks.end());
+            if (last->first + last->second == heapEnd) {
+                heapEnd = last->first;
+                freeBlocks.erase(last);
+            }
+        }
         const size_t allocatedAddr = heapEnd;
         heapEnd += size;  // 移动堆末端指针
         used += size;
-        peak = std::max(peak, used);
+        // peak 记录的是堆末端的最高位置，即实际需要申请的内存大小
+        peak = std::max(peak, heapEnd);
         return allocatedAddr;
     }
 
@@ -69,6 +94,14 @@ namespace infini
         // =================================== 作业 ===================================
         if(addr + size ==heapEnd){
             heapEnd = addr;
+            // 堆末端回退后，若最后一个空闲块与之相邻，一并回收
+            if (!freeBlocks.empty()) {
+                auto last = std::prev(freeBlocks.end());
+                if (last->first + last->second == heapEnd) {
+                    heapEnd = last->first;
+                    freeBlocks.erase(last);
+                }
+            }
         }else{
             // 插入新空闲块并获取迭代器
             auto [newIt, success] = freeBlocks.emplace(addr, size);
@@ -94,12 +127,134 @@ namespace infini
             }
         }
     }
+    vector<size_t> Allocator::plan(const vector<MemoryInterval> &intervals)
+    {
+        IT_ASSERT(this->ptr == nullptr);
+        // 每次规划都从空的内存开始，统计量不与上一次规划累加
+        used = peak = lowerBound = requested = padding = heapEnd = 0;
+        freeBlocks.clear();
+        blocks.clear();
+        vector<MemoryInterval> aligned(intervals);
+        for (auto &interval : aligned)
+        {
+            IT_ASSERT(interval.begin <= interval.end);
+            size_t size = getAlignedSize(interval.size);
+            requested += interval.size;
+            padding += size - interval.size;
+            interval.size = size;
+        }
+
+        // 下界：任一时刻同时存活的内存总量的最大值
+        std::map<size_t, long long> delta;
+        for (const auto &interval : aligned)
+        {
+            delta[interval.begin] += interval.size;
+            delta[interval.end + 1] -= interval.size;
+        }
+        long long live = 0;
+        size_t maxLive = 0;
+        for (const auto &[step, change] : delta)
+        {
+            live += change;
+            maxLive = std::max(maxLive, (size_t)live);
+        }
+        lowerBound = maxLive;
+
+        vector<size_t> order(aligned.size());
+        std::iota(order.begin(), order.end(), 0);
+        // 按生命周期起点排序，起点相同时保持输入顺序
+        std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b)
+                         { return aligned[a].begin < aligned[b].begin; });
+
+        vector<size_t> offsets;
+        switch (strategy)
+        {
+        case MemoryPlanStrategy::FirstFit:
+        {
+            // 按执行顺序回放：每一步先分配新出现的块，再释放在该步之后死亡的块
+            offsets.resize(aligned.size());
+            vector<size_t> byEnd(order);
+            std::stable_sort(byEnd.begin(), byEnd.end(), [&](size_t a, size_t b)
+                             { return aligned[a].end < aligned[b].end; });
+            auto freeIt = byEnd.begin();
+            for (auto i : order)
+            {
+                for (; freeIt != byEnd.end() &&
+                       aligned[*freeIt].end < aligned[i].begin;
+                     ++freeIt)
+                    free(offsets[*freeIt], aligned[*freeIt].size);
+                offsets[i] = allocAligned(aligned[i].size);
+            }
+            break;
+        }
+        case MemoryPlanStrategy::BestFit:
+            offsets = planBestFit(aligned, order);
+            break;
+        case MemoryPlanStrategy::GreedyBySize:
+            std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b)
+                             { return aligned[a].size > aligned[b].size; });
+            offsets = planBestFit(aligned, order);
+            break;
+        default:
+            IT_TODO_HALT();
+        }
+        for (size_t i = 0; i < aligned.size(); ++i)
+            blocks.push_back({aligned[i].tensor, offsets[i], aligned[i].size,
+                              intervals[i].size, aligned[i].begin,
+                              aligned[i].end});
+        return offsets;
+    }
+
+    vector<size_t>
+    Allocator::planBestFit(const vector<MemoryInterval> &intervals,
+                           const vector<size_t> &order)
+    {
+        vector<size_t> offsets(intervals.size());
+        vector<size_t> placed;
+        placed.reserve(intervals.size());
+        size_t extent = heapEnd;
+        for (auto i : order)
+        {
+            const auto &cur = intervals[i];
+            // 与当前块生命周期重叠的已放置块，按偏移量排序
+            vector<size_t> conflicts;
+            for (auto j : placed)
+                if (intervals[j].begin <= cur.end && cur.begin <= intervals[j].end)
+                    conflicts.emplace_back(j);
+            std::sort(conflicts.begin(), conflicts.end(), [&](size_t a, size_t b)
+                      { return offsets[a] < offsets[b]; });
+            // 在冲突块之间寻找能容纳当前块的最小空隙，找不到则放在末尾
+            size_t gapBegin = heapEnd, best = SIZE_MAX, bestGap = SIZE_MAX;
+            for (auto j : conflicts)
+            {
+                if (offsets[j] >= gapBegin)
+                {
+                    size_t gap = offsets[j] - gapBegin;
+                    if (gap >= cur.size && gap < bestGap)
+                    {
+                        best = gapBegin;
+                        bestGap = gap;
+                    }
+                }
+                gapBegin = std::max(gapBegin, offsets[j] + intervals[j].size);
+            }
+            offsets[i] = best != SIZE_MAX ? best : gapBegin;
+            extent = std::max(extent, offsets[i] + cur.size);
+            placed.emplace_back(i);
+        }
+        // 规划结果占据 [heapEnd, extent)，后续的在线分配从其末尾开始
+        heapEnd = extent;
+        peak = std::max(peak, heapEnd);
+        return offsets;
+    }
+
     void *Allocator::getPtr()
     {
         if (this->ptr == nullptr)
         {
             this->ptr = runtime->alloc(this->peak);
-            printf("Allocator really alloc: %p %lu bytes\n", this->ptr, peak);
+            IT_LOG(Debug) << "Allocated an arena of " << peak << " bytes at "
+                          << this->ptr;
         }
         return this->ptr;
     }
@@ -109,9 +264,86 @@ namespace infini
         return ((size - 1) / this->alignment + 1) * this->alignment;
     }
 
+    MemoryStats Allocator::getStats() const
+    {
+        MemoryStats stats{used, peak, lowerBound, requested, padding, 0, blocks};
+        if (blocks.empty())
+            return stats;
+        size_t first = SIZE_MAX, last = 0;
+        for (const auto &block : blocks)
+        {
+            first = std::min(first, block.begin);
+            last = std::max(last, block.end);
+        }
+        double live = 0, top = 0;
+        for (size_t step = first; step <= last; ++step)
+        {
+            size_t stepTop = 0;
+            for (const auto &block : blocks)
+                if (block.begin <= step && step <= block.end)
+                {
+                    live += block.size;
+                    stepTop = std::max(stepTop, block.offset + block.size);
+                }
+            top += stepTop;
+        }
+        stats.fragmentation = top > 0 ? 1 - live / top : 0;
+        return stats;
+    }
+
+    void Allocator::writeTimeline(std::ostream &os) const
+    {
+        auto stats = getStats();
+        os << "{\"alignment\": " << alignment << ", \"used\": " << stats.used
+           << ", \"peak\": " << stats.peak
+           << ", \"lower_bound\": " << stats.lowerBound
+           << ", \"requested\": " << stats.requested
+           << ", \"padding\": " << stats.padding
+           << ", \"fragmentation\": " << stats.fragmentation
+           << ",\n \"blocks\": [";
+        for (size_t i = 0; i < stats.blocks.size(); ++i)
+        {
+            const auto &b = stats.blocks[i];
+            os << (i ? "," : "") << "\n  {\"tensor\": " << b.tensor
+               << ", \"offset\": " << b.offset << ", \"size\": " << b.size
+               << ", \"requested\": " << b.requested
+               << ", \"begin\": " << b.begin << ", \"end\": " << b.end << "}";
+        }
+        os << "]}\n";
+    }
+
+    void Allocator::printLayout(std::ostream &os, size_t width) const
+    {
+        if (blocks.empty() || peak == 0 || width == 0)
+            return;
+        size_t last = 0;
+        for (const auto &block : blocks)
+            last = std::max(last, block.end);
+        double bytesPerColumn = double(peak) / width;
+        os << "arena of " << peak << " bytes, " << bytesPerColumn
+           << " bytes per column\n";
+        for (size_t step = 0; step <= last; ++step)
+        {
+            string row(width, '.');
+            for (const auto &block : blocks)
+            {
+                if (step < block.begin || block.end < step)
+                    continue;
+                size_t begin = size_t(block.offset / bytesPerColumn);
+                size_t end = size_t((block.offset + block.size - 1) /
+                                    bytesPerColumn);
+                for (size_t c = begin; c <= end && c < width; ++c)
+                    row[c] = '#';
+            }
+            os << std::setw(6) << step << " |" << row << "|\n";
+        }
+    }
+
     void Allocator::info()
     {
-        std::cout << "Used memory: " << this->used
-                  << ", peak memory: " << this->peak << std::endl;
+        IT_LOG(Info) << "Used memory: " << this->used
+                     << ", peak memory: " << this->peak
+                     << ", lower bound: " << this->lowerBound
+                     << ", alignment padding: " << this->padding;
     }
 }
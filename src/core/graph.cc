@@ -1,5 +1,11 @@
 #include "core/graph.h"
+#include "core/kernel.h"
+#include "operators/concat.h"
+#include "operators/element_wise.h"
+#include "operators/fused_element_wise.h"
+#include "operators/unary.h"
 #include <algorithm>
+#include <deque>
 #include <numeric>
 #include <queue>
 namespace infini
@@ -8,6 +14,8 @@ namespace infini
     void GraphObj::addOperatorAndConnect(const Operator &op)
     {
         sorted = false;
+        memoryPlans.clear();
+        opIndex[op.get()] = ops.size();
         ops.push_back(op);
         for (auto &input : op->getInputs())
         {
@@ -39,11 +47,11 @@ namespace infini
     {
         std::ostringstream oss;
         oss << "Graph Tensors:\n";
-        for (const auto &tensor : tensors)
+        for (const auto &tensor : getTensors())
             oss << tensor << "\n";
 
         oss << "Graph operators:\n";
-        for (const auto &op : ops)
+        for (const auto &op : getOperators())
         {
             vector<UidBaseType> preds, succs;
             for (auto &o : op->getPredecessors())
@@ -60,39 +68,57 @@ namespace infini
 
     bool GraphObj::topo_sort()
     {
+        compact();
         if (this->sorted)
         {
             return true;
         }
-        std::vector<Operator> sorted;
-        std::unordered_set<OperatorObj *> flags;
-        sorted.reserve(ops.size());
-        flags.reserve(ops.size());
-        while (sorted.size() < ops.size())
+        // Kahn's algorithm over the predecessor/successor edges. An operator
+        // is ready once all of its distinct predecessors are placed; ready
+        // operators are placed in the order they had.
+        size_t n = ops.size();
+        vector<vector<size_t>> successors(n);
+        vector<size_t> pending(n, 0);
+        // the last operator that counted an edge to each operator, so that
+        // duplicated edges are counted once
+        vector<size_t> seen(n, SIZE_MAX);
+        bool inOrder = true;
+        for (size_t i = 0; i < n; ++i)
         {
-            // Any node is move to sorted in this loop.
-            auto modified = false;
-            for (auto const &op : ops)
-            {
-                if (auto const &inputs = op->getInputs();
-                    flags.find(op.get()) == flags.end() &&
-                    std::all_of(inputs.begin(), inputs.end(),
-                                [&flags](auto const &input)
-                                {
-                                    auto ptr = input->getSource().get();
-                                    return !ptr || flags.find(ptr) != flags.end();
-                                }))
-                {
-                    modified = true;
-                    sorted.emplace_back(op);
-                    flags.insert(op.get());
-                }
-            }
-            if (!modified)
+            for (auto &succ : ops[i]->getSuccessors())
             {
-                return false;
+                auto it = opIndex.find(succ.get());
+                if (it == opIndex.end() || seen[it->second] == i)
+                    continue;
+                seen[it->second] = i;
+                successors[i].emplace_back(it->second);
+                ++pending[it->second];
+                inOrder &= it->second > i;
             }
         }
+        if (inOrder)
+            return this->sorted = true;
+
+        vector<size_t> order;
+        order.reserve(n);
+        for (size_t i = 0; i < n; ++i)
+            if (pending[i] == 0)
+                order.emplace_back(i);
+        for (size_t head = 0; head < order.size(); ++head)
+            for (auto succ : successors[order[head]])
+                if (--pending[succ] == 0)
+                    order.emplace_back(succ);
+        if (order.size() < n)
+        {
+            return false;
+        }
+        OpVec sorted;
+        sorted.reserve(n);
+        for (auto i : order)
+        {
+            opIndex[ops[i].get()] = sorted.size();
+            sorted.emplace_back(ops[i]);
+        }
         this->ops = std::move(sorted);
         return this->sorted = true;
     }
@@ -105,146 +131,508 @@ namespace infini
         // 1. 去除冗余的算子（例如，两个相邻的算子都是 transpose 算子，且做的是相反的操作，可以将其全部删除）
         // 2. 合并算子（例如，矩阵乘算子中含有属性transA、transB，如果其输入存在transpose，且对最后两个维度做交换，就可以将transpose融入到矩阵乘算子的属性中去）
         // =================================== 作业 ===================================
-    // Step 1: Remove redundant transpose pairs
-    auto it = ops.begin();
-    while (it != ops.end()) {
-        if (it + 1 != ops.end() && 
-            (*it)->getOpType() == OpType::Transpose && 
-            (*(it+1))->getOpType() == OpType::Transpose) {
-            // auto &t1 = *it;
-            // auto &t2 = *(it+1);
-            // 动态转换为 TransposeObj 以访问转置轴属性
-            auto t1 = std::dynamic_pointer_cast<TransposeObj>(*it);
-            auto t2 = std::dynamic_pointer_cast<TransposeObj>(*(it + 1));
-            // Check if transpose axes are the same (reverse order)
-            if ( t1->getOutputs()[0] == t2->getInputs()[0]) {
-                // 检查轴顺序是否互为逆操作
-                auto permute1 = t1->getPermute();
-                auto permute2 = t2->getPermute();
-                bool isInverse = true;
-                for (size_t i = 0; i < permute1.size(); ++i) {
-                    if (permute1[permute2[i]] != (int)i) {
-                        isInverse = false;
-                        break;
-                    }
-                }
-                if (isInverse) {
-                    // 删除两个转置算子，直接连接 t1 的输入到 t2 的输出
-                    auto inputTensor = t1->getInputs()[0];
-                    auto outputTensor = t2->getOutputs()[0];
-                    outputTensor->setSource(inputTensor->getSource());
-                    removeOperator(t2);
-                    it = ops.erase(it + 1);
-                    removeOperator(t1);
-                    it = ops.erase(it);
-                    continue;
-                }
+        // 每个规则删除的算子和张量在下一个规则读取图之前整理掉
+        foldConstants();
+        compact();
+        canonicalizeTransposes();
+        compact();
+        foldTransposeIntoMatmul();
+        compact();
+        fuseMatmulEpilogue();
+        compact();
+        fuseElementWise();
+        compact();
+    }
+
+    void GraphObj::removeOperator(Operator op)
+    {
+        auto it = opIndex.find(op.get());
+        if (it == opIndex.end())
+            return;
+        memoryPlans.clear();
+        // 断开算子与输入、输出张量以及前驱、后继算子之间的连接
+        for (auto &input : op->getInputs())
+        {
+            input->removeTarget(op);
+            if (auto pred = input->getSource())
+                pred->removeSuccessors(op);
+        }
+        for (auto &output : op->getOutputs())
+        {
+            output->source.reset();
+            for (auto &succ : output->getTargets())
+                succ->removePredecessors(op);
+        }
+        op->predecessors.clear();
+        op->successors.clear();
+        ops[it->second] = nullptr;
+        opIndex.erase(it);
+        ++removedOps;
+    }
+
+    void GraphObj::removeTensor(Tensor tensor)
+    {
+        auto it = tensorIndex.find(tensor.get());
+        if (it == tensorIndex.end())
+            return;
+        memoryPlans.clear();
+        auto fuid = fuidIndex.find(tensor->getFuid());
+        if (fuid != fuidIndex.end() && fuid->second == tensor)
+            fuidIndex.erase(fuid);
+        tensors[it->second] = nullptr;
+        tensorIndex.erase(it);
+        ++removedTensors;
+    }
+
+    void GraphObj::compact()
+    {
+        if (removedOps > 0)
+        {
+            ops.erase(std::remove(ops.begin(), ops.end(), nullptr), ops.end());
+            for (size_t i = 0; i < ops.size(); ++i)
+                opIndex[ops[i].get()] = i;
+            removedOps = 0;
+        }
+        if (removedTensors > 0)
+        {
+            tensors.erase(std::remove(tensors.begin(), tensors.end(), nullptr),
+                          tensors.end());
+            for (size_t i = 0; i < tensors.size(); ++i)
+                tensorIndex[tensors[i].get()] = i;
+            removedTensors = 0;
+        }
+    }
+
+    void GraphObj::replaceInput(const Operator &op, const Tensor &oldInput,
+                                const Tensor &newInput)
+    {
+        op->replaceInput(oldInput, newInput);
+        oldInput->removeTarget(op);
+        if (auto pred = oldInput->getSource())
+        {
+            // 仅当没有其他输入来自同一个前驱时才断开前驱关系
+            auto inputs = op->getInputs();
+            if (std::none_of(inputs.begin(), inputs.end(),
+                             [&](const Tensor &t)
+                             { return t->getSource() == pred; }))
+            {
+                pred->removeSuccessors(op);
+                op->removePredecessors(pred);
             }
         }
-        ++it;
+        newInput->addTarget(op);
+        if (auto pred = newInput->getSource())
+        {
+            pred->addSuccessors(op);
+            op->addPredecessors(pred);
+        }
+        sorted = false;
+        memoryPlans.clear();
     }
 
-   // Step 2: 合并 Transpose 到 Matmul
-   for (auto &op : ops) {
-    // 1. 检查当前算子是否为 Matmul
-    if (op->getOpType() != OpType::MatMul)
-        continue;
-
-    // 2. 动态转换为 MatmulObj 以访问 transA/transB 属性
-    auto matmul = std::dynamic_pointer_cast<MatmulObj>(op);
-    if (!matmul)
-        continue;
-
-    // 3. 处理输入 A 的前置 Transpose
-    auto inputA = matmul->getInputs()[0];
-    if (inputA->getSource() && 
-        inputA->getSource()->getOpType() == OpType::Transpose) {
-        auto transposeA = std::dynamic_pointer_cast<TransposeObj>(inputA->getSource());
-        if (transposeA) {
-            // 检查 Transpose 是否仅交换最后两个维度
-            auto permute = transposeA->getPermute();
-            bool isLastTwoSwapped = true;
-            for (size_t i = 0; i < permute.size() - 2; ++i) {
-                if (permute[i] != (int)i) {
-                    isLastTwoSwapped = false;
+    void GraphObj::foldConstants()
+    {
+        // 0. 常量折叠：输入全部是常量（如权重）的算子在优化时用 CPU 内核计算一次，
+        // 输出成为常量，算子从图中删除，推理时不再重复计算。
+        // 按拓扑序处理，常量子图可以逐层折叠完
+        auto isConstant = [](const Tensor &t)
+        { return t->isConstant(); };
+        if (std::none_of(tensors.begin(), tensors.end(),
+                         [&](const Tensor &t)
+                         { return t && isConstant(t); }) ||
+            !topo_sort())
+            return;
+        const auto &registry = KernelRegistry::getInstance();
+        OpVec candidates = getOperators();
+        for (auto &op : candidates)
+        {
+            auto inputs = op->getInputs();
+            if (inputs.empty() ||
+                !std::all_of(inputs.begin(), inputs.end(), isConstant))
+                continue;
+            // 图的输出仍由算子产生，否则折叠后它既没有来源也没有消费者
+            auto outputs = op->getOutputs();
+            if (std::any_of(outputs.begin(), outputs.end(),
+                            [](const Tensor &t)
+                            { return t->getTargets().empty(); }))
+                continue;
+            for (auto &output : op->getOutputs())
+                output->setConstant();
+            registry
+                .getKernel({Device::CPU, op->getOpType().underlying()})
+                ->compute(op, runtime.get());
+            removeOperator(op);
+            // 只被折叠掉的算子读取的常量不再需要
+            for (auto &input : inputs)
+                if (input->getTargets().empty())
+                    removeTensor(input);
+        }
+    }
+
+    static bool isIdentityPermute(const vector<int> &permute)
+    {
+        for (size_t i = 0; i < permute.size(); ++i)
+            if (permute[i] != (int)i)
+                return false;
+        return true;
+    }
+
+    static bool isLastTwoSwapped(const vector<int> &permute)
+    {
+        auto rank = permute.size();
+        if (rank < 2)
+            return false;
+        for (size_t i = 0; i + 2 < rank; ++i)
+            if (permute[i] != (int)i)
+                return false;
+        return permute[rank - 2] == (int)(rank - 1) &&
+               permute[rank - 1] == (int)(rank - 2);
+    }
+
+    // transpose 可以下沉穿过的逐元素算子
+    static bool commutesWithTranspose(OpType type)
+    {
+        switch (type.underlying())
+        {
+        case OpType::Add:
+        case OpType::Sub:
+        case OpType::Mul:
+        case OpType::Div:
+        case OpType::Relu:
+        case OpType::Clip:
+        case OpType::Cast:
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    // 沿着只有一个消费者的一元算子向后看：tensor 上做 permute 的 transpose
+    // 下沉之后，能否与后面的 transpose 合成，或被矩阵乘的 transA、transB 吸收
+    static bool absorbsTranspose(Tensor tensor, const vector<int> &permute)
+    {
+        while (true)
+        {
+            auto targets = tensor->getTargets();
+            if (targets.size() != 1)
+                return false;
+            auto consumer = targets[0];
+            auto type = consumer->getOpType();
+            if (type == OpType::Transpose)
+                return true;
+            if (type == OpType::MatMul)
+                return isLastTwoSwapped(permute) &&
+                       (consumer->getInputs(0) == tensor) !=
+                           (consumer->getInputs(1) == tensor);
+            if (type != OpType::Relu && type != OpType::Clip &&
+                type != OpType::Cast)
+                return false;
+            tensor = consumer->getOutput();
+        }
+    }
+
+    void GraphObj::canonicalizeTransposes()
+    {
+        // 1. 沿张量的实际连接规范化 transpose：
+        //   a. 前后相接的 transpose 合成一个，合成后的置换为 p1[p2[i]]
+        //   b. 恒等置换的 transpose 直接删除
+        //   c. transpose 下沉穿过逐元素算子。两个输入经过相同置换的二元算子
+        //      只需对输出做一次 transpose；一元算子只有在下沉后能被合成或
+        //      被矩阵乘吸收时才下沉，否则只会妨碍逐元素算子的融合
+        // 新产生的 transpose 及其消费者重新入队，因此任意长的链都能化简
+        std::deque<Operator> worklist(getOperators().begin(),
+                                      getOperators().end());
+        auto enqueue = [&](const Operator &transpose)
+        {
+            worklist.emplace_back(transpose);
+            for (auto &target : transpose->getOutput()->getTargets())
+                worklist.emplace_back(target);
+        };
+        while (!worklist.empty())
+        {
+            auto op = worklist.front();
+            worklist.pop_front();
+            if (!hasOperator(op) || op->getOpType() != OpType::Transpose)
+                continue;
+            auto transpose = as<TransposeObj>(op);
+            auto permute = transpose->getPermute();
+            auto input = transpose->getInputs(0);
+            auto output = transpose->getOutput();
+            auto source = input->getSource();
+            if (source && source->getOpType() == OpType::Transpose)
+            {
+                auto first = as<TransposeObj>(source);
+                auto inner = first->getPermute();
+                vector<int> composed(permute.size());
+                for (size_t i = 0; i < permute.size(); ++i)
+                    composed[i] = inner[permute[i]];
+                removeOperator(transpose);
+                // 第一个 transpose 的输出可能还有其他消费者
+                if (input->getTargets().empty())
+                {
+                    removeOperator(first);
+                    removeTensor(input);
+                }
+                enqueue(addOpWithOutputs<TransposeObj>(first->getInputs(0),
+                                                       output, composed));
+                continue;
+            }
+            auto targets = output->getTargets();
+            // 图的输出张量需要保留
+            if (targets.empty())
+                continue;
+            if (isIdentityPermute(permute))
+            {
+                for (auto &target : targets)
+                {
+                    replaceInput(target, output, input);
+                    worklist.emplace_back(target);
+                }
+                removeOperator(transpose);
+                removeTensor(output);
+                continue;
+            }
+
+            auto consumer = targets[0];
+            if (std::any_of(targets.begin(), targets.end(),
+                            [&](const Operator &t)
+                            { return t != consumer; }) ||
+                !commutesWithTranspose(consumer->getOpType()))
+                continue;
+            // 消费者的每个输入都必须来自同样置换的 transpose，且只被它读取
+            TensorVec inputs;
+            bool sinkable = true;
+            for (auto &t : consumer->getInputs())
+            {
+                auto s = t->getSource();
+                auto ts = t->getTargets();
+                sinkable = s && s->getOpType() == OpType::Transpose &&
+                           as<TransposeObj>(s)->getPermute() == permute &&
+                           std::all_of(ts.begin(), ts.end(),
+                                       [&](const Operator &o)
+                                       { return o == consumer; });
+                if (!sinkable)
                     break;
+                if (std::find(inputs.begin(), inputs.end(),
+                              s->getInputs(0)) == inputs.end())
+                    inputs.emplace_back(s->getInputs(0));
+            }
+            auto result = consumer->getOutput();
+            if (!sinkable ||
+                (inputs.size() < 2 && !absorbsTranspose(result, permute)))
+                continue;
+            // 逐元素算子改为直接读取 transpose 之前的张量，再对结果做一次 transpose
+            Shape dims(permute.size());
+            for (size_t i = 0; i < permute.size(); ++i)
+                dims[permute[i]] = result->getDims()[i];
+            auto moved = addTensor(dims, result->getDType());
+            TensorVec newInputs;
+            for (auto &t : consumer->getInputs())
+                newInputs.emplace_back(t->getSource()->getInputs(0));
+            removeOperator(consumer);
+            for (auto &t : consumer->getInputs())
+            {
+                if (hasTensor(t) && t->getTargets().empty())
+                {
+                    removeOperator(t->getSource());
+                    removeTensor(t);
                 }
             }
-            if (isLastTwoSwapped && 
-                permute[permute.size() - 2] == (int)(permute.size() - 1) &&
-                permute[permute.size() - 1] == (int)(permute.size() - 2)) {
-                // 合并到 Matmul 的 transA 属性
-                matmul->setTransA(!matmul->getTransA());
-                // 将 Matmul 的输入直接连接到 Transpose 的输入
-                matmul->replaceInput(inputA, transposeA->getInputs()[0]);
-                removeOperator(transposeA);
+            addOperatorAndConnect(consumer->clone(newInputs, {moved}));
+            enqueue(addOpWithOutputs<TransposeObj>(moved, result, permute));
+        }
+    }
+
+    void GraphObj::foldTransposeIntoMatmul()
+    {
+        // 2. 合并算子：只交换最后两个维度的 transpose 融入矩阵乘的 transA、transB 属性
+        OpVec candidates = getOperators();
+        for (auto &op : candidates)
+        {
+            if (op->getOpType() != OpType::MatMul)
+                continue;
+            auto matmul = as<MatmulObj>(op);
+            // 两个输入为同一个张量时无法分别修改 transA、transB
+            if (matmul->getInputs(0) == matmul->getInputs(1))
+                continue;
+            for (int i = 0; i < 2; ++i)
+            {
+                auto input = matmul->getInputs(i);
+                auto source = input->getSource();
+                if (!source || source->getOpType() != OpType::Transpose)
+                    continue;
+                auto transpose = as<TransposeObj>(source);
+                if (!isLastTwoSwapped(transpose->getPermute()))
+                    continue;
+                if (i == 0)
+                    matmul->setTransA(!matmul->getTransA());
+                else
+                    matmul->setTransB(!matmul->getTransB());
+                replaceInput(matmul, input, transpose->getInputs(0));
+                if (input->getTargets().empty())
+                {
+                    removeOperator(transpose);
+                    removeTensor(input);
+                }
             }
         }
     }
 
-    // 4. 处理输入 B 的前置 Transpose（逻辑同上）
-    auto inputB = matmul->getInputs()[1];
-    if (inputB->getSource() && 
-        inputB->getSource()->getOpType() == OpType::Transpose) {
-        auto transposeB = std::dynamic_pointer_cast<TransposeObj>(inputB->getSource());
-        if (transposeB) {
-            auto permute = transposeB->getPermute();
-            bool isLastTwoSwapped = true;
-            for (size_t i = 0; i < permute.size() - 2; ++i) {
-                if (permute[i] != (int)i) {
-                    isLastTwoSwapped = false;
+    void GraphObj::fuseMatmulEpilogue()
+    {
+        // 把矩阵乘之后的 bias 加法、Relu 和 Clip 融入矩阵乘的 epilogue，
+        // 在写回 C 的分块时顺带完成，省去对 C 的两次额外读写
+        OpVec candidates = getOperators();
+        for (auto &op : candidates)
+        {
+            if (op->getOpType() != OpType::MatMul ||
+                !(op->getDType() == DataType::Float32))
+                continue;
+            auto matmul = as<MatmulObj>(op);
+            while (true)
+            {
+                auto middle = matmul->getOutput();
+                auto targets = middle->getTargets();
+                if (targets.size() != 1)
+                    break;
+                auto consumer = targets[0];
+                auto type = consumer->getOpType();
+                auto output = consumer->getOutput();
+                if (output->getDims() != middle->getDims())
                     break;
+                if (type == OpType::Add)
+                {
+                    // bias 必须在截断之前加上
+                    auto bias = consumer->getInputs(0) == middle
+                                    ? consumer->getInputs(1)
+                                    : consumer->getInputs(0);
+                    if (bias == middle || matmul->getBias() ||
+                        matmul->getMin() || matmul->getMax() ||
+                        !(bias->getDType() == DataType::Float32))
+                        break;
+                    matmul->inputs.emplace_back(bias);
                 }
-            }
-            if (isLastTwoSwapped && 
-                permute[permute.size() - 2] == (int)(permute.size() - 1) &&
-                permute[permute.size() - 1] == (int)(permute.size() - 2)) {
-                matmul->setTransB(!matmul->getTransB());
-                matmul->replaceInput(inputB, transposeB->getInputs()[0]);
-                removeOperator(transposeB);
+                else if (type == OpType::Relu)
+                    matmul->clampOutput(0.f, {});
+                else if (type == OpType::Clip)
+                {
+                    auto clip = as<ClipObj>(consumer);
+                    matmul->clampOutput(clip->getMin(), clip->getMax());
+                }
+                else
+                    break;
+                // 由矩阵乘直接写出消费者的输出张量
+                removeOperator(consumer);
+                removeOperator(matmul);
+                removeTensor(middle);
+                matmul->outputs = {output};
+                addOperatorAndConnect(matmul);
             }
         }
     }
+
+    // Expresses an element-wise or unary operator as the inputs and steps of
+    // a fused operator.
+    static pair<TensorVec, vector<FusedElementWiseObj::Step>>
+    fusedSteps(const Operator &op)
+    {
+        auto type = op->getOpType();
+        if (type == OpType::FusedElementWise)
+        {
+            auto fused = as<FusedElementWiseObj>(op);
+            return {fused->getInputs(), fused->getSteps()};
+        }
+        if (type == OpType::Relu)
+            return {op->getInputs(), {{type, 0, 0, {}, {}}}};
+        if (type == OpType::Clip)
+        {
+            auto clip = as<ClipObj>(op);
+            return {op->getInputs(),
+                    {{type, 0, 0, clip->getMin(), clip->getMax()}}};
+        }
+        if (op->getInputs(0) == op->getInputs(1))
+            return {{op->getInputs(0)}, {{type, 0, 0, {}, {}}}};
+        return {op->getInputs(), {{type, 0, 1, {}, {}}}};
     }
-    }
-    // void GraphObj::removeOperator(OperatorObj &op) {
-    //     // 断开输入和输出的链接
-    //     for (auto input : op.getInputs()) {
-    //         input->removeTarget(op);
-    //         if (auto source = input->getSource()) {
-    //             source->removeSuccessors(op);
-    //             op.removePredecessors(source);
-    //         }
-    //     }
-    //     for (auto output : op.getOutputs()) {
-    //         output->setSource(nullptr);
-    //         for (auto successor = output->getTargets()) {
-    //             successor->removePredecessors(op);
-    //             op.removeSuccessors(successor);
-    //         }
-    //     }
-        
-    //     // 从操作符列表中移除
-    //     auto it = std::find(ops.begin(), ops.end(), op);
-    //     if (it != ops.end()) {
-    //         ops.erase(it);
-    //     }
-    // }
-    Tensor GraphObj::getTensor(int fuid) const
+
+    void GraphObj::fuseElementWise()
     {
-        for (auto tensor : tensors)
+        // 3. 融合逐元素算子链：生产者的输出只被一个逐元素算子消费、且两者输出形状
+        // 相同时，把两者合并为一个 FusedElementWise 算子，中间张量不再分配内存
+        // 每个算子作为生产者检查一次；融合后，新算子及其输入的生产者重新入队，
+        // 因为它们可能因此变得可以融合
+        std::deque<Operator> worklist(getOperators().begin(),
+                                      getOperators().end());
+        while (!worklist.empty())
         {
-            if (tensor->getFuid() == fuid)
+            auto producer = worklist.front();
+            worklist.pop_front();
+            if (!hasOperator(producer) ||
+                !FusedElementWiseObj::isFusible(producer->getOpType()))
+                continue;
+            auto middle = producer->getOutput();
+            auto targets = middle->getTargets();
+            if (targets.empty())
+                continue;
+            auto consumer = targets[0];
+            if (std::any_of(targets.begin(), targets.end(),
+                            [&](const Operator &t)
+                            { return t != consumer; }) ||
+                !FusedElementWiseObj::isFusible(consumer->getOpType()))
+                continue;
+            auto output = consumer->getOutput();
+            if (output->getDims() != middle->getDims() ||
+                !(output->getDType() == middle->getDType()) ||
+                !(consumer->getDType() == middle->getDType()))
+                continue;
+
+            auto [inputs, steps] = fusedSteps(producer);
+            TensorVec consumerInputs;
+            vector<FusedElementWiseObj::Step> consumerSteps;
+            std::tie(consumerInputs, consumerSteps) = fusedSteps(consumer);
+            size_t shift = steps.size();
+            auto remap = [&, &inputs = inputs](int operand)
             {
-                return tensor;
+                if (operand < 0)
+                    return FusedElementWiseObj::stepOperand(
+                        FusedElementWiseObj::operandStep(operand) + shift);
+                auto tensor = consumerInputs[operand];
+                if (tensor == middle)
+                    return FusedElementWiseObj::stepOperand(shift - 1);
+                auto it = std::find(inputs.begin(), inputs.end(), tensor);
+                if (it != inputs.end())
+                    return (int)(it - inputs.begin());
+                inputs.emplace_back(tensor);
+                return (int)inputs.size() - 1;
+            };
+            for (auto step : consumerSteps)
+            {
+                step.lhs = remap(step.lhs);
+                if (step.type != OpType::Relu && step.type != OpType::Clip)
+                    step.rhs = remap(step.rhs);
+                steps.emplace_back(step);
             }
+            removeOperator(producer);
+            removeOperator(consumer);
+            removeTensor(middle);
+            auto fused =
+                addOpWithOutputs<FusedElementWiseObj>(inputs, output, steps);
+            worklist.emplace_back(fused);
+            for (auto &input : fused->getInputs())
+                if (auto source = input->getSource())
+                    worklist.emplace_back(source);
         }
-        return nullptr;
+    }
+
+    Tensor GraphObj::getTensor(int fuid) const
+    {
+        auto it = fuidIndex.find(fuid);
+        return it == fuidIndex.end() ? nullptr : it->second;
     }
 
     void GraphObj::shape_infer()
     {
-        for (auto &op : ops)
+        for (auto &op : getOperators())
         {
             auto ans = op->inferShape();
             IT_ASSERT(ans.has_value());
@@ -269,35 +657,195 @@ namespace infini
     {
         // topological sorting first
         IT_ASSERT(topo_sort() == true);
+        compact();
 
+        // 同一组输入形状的内存规划只做一次：缓存命中时直接把张量绑定回
+        // 该规划的内存，不再规划，也不再申请内存
+        vector<Shape> key;
+        for (const auto &input : getInputs())
+            key.emplace_back(input->getDims());
+        auto cached = memoryPlans.find(key);
+        if (cached == memoryPlans.end())
+        {
+            // 缓存已满时淘汰最久未使用的规划；已编译的执行计划仍持有它的内存
+            if (memoryPlans.size() >= maxMemoryPlans)
+                memoryPlans.erase(std::min_element(
+                    memoryPlans.begin(), memoryPlans.end(),
+                    [](const auto &a, const auto &b)
+                    { return a.second.lastUse < b.second.lastUse; }));
+            cached = memoryPlans.emplace(key, planMemory()).first;
+        }
+        auto &plan = cached->second;
+        plan.lastUse = ++planUses;
+        allocator = plan.allocator;
+        auto basePtr = static_cast<char *>(allocator->getPtr());
+        for (size_t i = 0; i < tensors.size(); ++i)
+        {
+            // 规划之后才被标记为常量的张量已经有了自己的内存
+            const auto &data = tensors[i]->data;
+            if (plan.offsets[i] == string::npos ||
+                (data && data->isExternal()))
+                continue;
+            // 创建Blob并设置到张量中
+            tensors[i]->setDataBlob(
+                make_ref<BlobObj>(runtime, basePtr + plan.offsets[i]));
+        }
+    }
+
+    GraphObj::MemoryPlan GraphObj::planMemory() const
+    {
         // =================================== 作业 ===================================
         // TODO：利用 allocator 给计算图分配内存
         // HINT: 获取分配好的内存指针后，可以调用 tensor 的 setDataBlob 函数给 tensor 绑定内存
         // =================================== 作业 ===================================
 
 
-         // 分配内存偏移量并记录
-        std::unordered_map<Tensor, size_t> tensorOffsets;
-        for (const auto& tensor : tensors) {
-            size_t size = tensor->getBytes();
-            size_t offset = allocator.alloc(size);
-            tensorOffsets[tensor] = offset;
+        // 以拓扑序中的下标作为时间步，计算每个张量的生命周期：
+        // 张量在其生产者执行时出现，在最后一个消费者执行后死亡。
+        // 图的输入与输出在整个推理过程中保持驻留。
+        std::unordered_map<OperatorObj *, size_t> step;
+        for (size_t i = 0; i < ops.size(); ++i)
+            step[ops[i].get()] = i;
+        std::unordered_map<TensorObj *, MemoryInterval> lifetime;
+        for (const auto &tensor : tensors)
+        {
+            auto source = tensor->getSource();
+            auto targets = tensor->getTargets();
+            MemoryInterval interval{tensor->getBytes(), 0, ops.size(),
+                                    tensor->getFuid()};
+            if (source)
+                interval.begin = step[source.get()];
+            if (source && !targets.empty())
+            {
+                interval.end = interval.begin;
+                for (const auto &target : targets)
+                    interval.end = std::max(interval.end, step[target.get()]);
+            }
+            lifetime[tensor.get()] = interval;
         }
-        // 实际分配内存
-        void* basePtr = allocator.getPtr();
-           // 绑定内存到各个张量
-        for (const auto& tensor : tensors) {
-            size_t offset = tensorOffsets[tensor];
-            void* dataPtr = static_cast<char*>(basePtr) + offset;
-            // 创建Blob并设置到张量中
-            tensor->setDataBlob(make_ref<BlobObj>(runtime, dataPtr));
+
+        // 零拷贝 Concat：沿最外层非平凡维度拼接时，每个输入在输出中占据一段连续内存，
+        // 让输入的生产者直接写入这段内存，Concat 在运行时就无需拷贝。
+        // 输入是图的输入、或者还有其他消费者时无法别名，仍由 Concat 拷贝。
+        auto aliases = planConcatAliases();
+        // 别名张量并入其根张量的生命周期，自身不再单独分配
+        auto rootOf = [&](TensorObj *tensor)
+        {
+            size_t offset = 0;
+            for (auto it = aliases.find(tensor); it != aliases.end();
+                 it = aliases.find(tensor))
+            {
+                offset += it->second.second;
+                tensor = it->second.first;
+            }
+            return std::make_pair(tensor, offset);
+        };
+        // 已绑定外部内存（如映射的模型文件中的权重）的张量不进入内存规划
+        auto external = [](const Tensor &tensor)
+        { return tensor->data && tensor->data->isExternal(); };
+        // 原地执行：逐元素算子的某个输入在它之后不再被使用、且形状和类型都与输出
+        // 相同时，输出直接复用这个输入的内存。这些算子的内核在同一下标上先读后写，
+        // 形状相同的输入与输出下标一一对应，所以可以原地计算。
+        // 图的输入和外部内存中的常量不能被覆盖
+        for (size_t i = 0; i < ops.size(); ++i)
+        {
+            const auto &op = ops[i];
+            if (!FusedElementWiseObj::isFusible(op->getOpType()))
+                continue;
+            auto output = op->getOutput();
+            if (aliases.count(output.get()) || external(output))
+                continue;
+            for (const auto &input : op->getInputs())
+            {
+                if (!input->getSource() || external(input) ||
+                    lifetime[input.get()].end != i ||
+                    input->getDims() != output->getDims() ||
+                    !(input->getDType() == output->getDType()))
+                    continue;
+                aliases[output.get()] = {input.get(), 0};
+                break;
+            }
         }
-        allocator.info();
+        for (const auto &[tensor, alias] : aliases)
+        {
+            auto &root = lifetime[rootOf(tensor).first];
+            const auto &own = lifetime[tensor];
+            root.begin = std::min(root.begin, own.begin);
+            root.end = std::max(root.end, own.end);
+        }
+        vector<MemoryInterval> intervals;
+        vector<size_t> slot(tensors.size());
+        for (size_t i = 0; i < tensors.size(); ++i)
+        {
+            if (aliases.count(tensors[i].get()) || external(tensors[i]))
+                continue;
+            slot[i] = intervals.size();
+            intervals.emplace_back(lifetime[tensors[i].get()]);
+        }
+        MemoryPlan plan{std::make_shared<Allocator>(runtime), {}};
+        plan.allocator->setStrategy(memoryPlanStrategy);
+        auto offsets = plan.allocator->plan(intervals);
+
+        // 每个张量在内存中的偏移，别名张量位于其根张量之内
+        std::unordered_map<TensorObj *, size_t> rootSlot;
+        for (size_t i = 0; i < tensors.size(); ++i)
+            rootSlot[tensors[i].get()] = slot[i];
+        plan.offsets.assign(tensors.size(), string::npos);
+        for (size_t i = 0; i < tensors.size(); ++i) {
+            if (external(tensors[i]))
+                continue;
+            auto [root, offset] = rootOf(tensors[i].get());
+            plan.offsets[i] = offset + offsets[rootSlot[root]];
+        }
+        plan.allocator->info();
+        return plan;
+    }
+
+    void GraphObj::setInputShapes(const vector<Shape> &shapes)
+    {
+        auto inputs = getInputs();
+        IT_ASSERT(shapes.size() == inputs.size(),
+                  "Expected shapes of " + std::to_string(inputs.size()) +
+                      " graph inputs, got " + std::to_string(shapes.size()));
+        for (size_t i = 0; i < inputs.size(); ++i)
+            inputs[i]->setShape(shapes[i]);
+        IT_ASSERT(topo_sort() == true);
+        shape_infer();
+        dataMalloc();
+    }
+
+    std::unordered_map<TensorObj *, pair<TensorObj *, size_t>>
+    GraphObj::planConcatAliases() const
+    {
+        std::unordered_map<TensorObj *, pair<TensorObj *, size_t>> aliases;
+        for (const auto &op : getOperators())
+        {
+            if (op->getOpType() != OpType::Concat)
+                continue;
+            auto output = op->getOutput();
+            auto dims = output->getDims();
+            auto dim = as<ConcatObj>(op)->getDim();
+            // 拼接维度之前的维度都为 1 时，每个输入才对应输出中的一段连续内存
+            if (std::any_of(dims.begin(), dims.begin() + dim,
+                            [](int d)
+                            { return d != 1; }))
+                continue;
+            size_t offset = 0;
+            for (const auto &input : op->getInputs())
+            {
+                // 同一张量出现两次时 targets 中也会有两个 Concat
+                auto targets = input->getTargets();
+                if (input->getSource() && targets.size() == 1)
+                    aliases[input.get()] = {output.get(), offset};
+                offset += input->getBytes();
+            }
+        }
+        return aliases;
     }
 
     Tensor GraphObj::addTensor(Shape dim, DataType dtype)
     {
-        return tensors.emplace_back(make_ref<TensorObj>(dim, dtype, runtime));
+        return addTensor(make_ref<TensorObj>(dim, dtype, runtime));
     }
 
     Tensor GraphObj::addTensor(const Tensor &tensor)
@@ -306,7 +854,11 @@ namespace infini
                   std::string("Tensor runtime mismatch: cannot add a tenosr in ") +
                       tensor->getRuntime()->toString() + " to " +
                       runtime->toString());
+        if (!tensorIndex.emplace(tensor.get(), tensors.size()).second)
+            return tensor;
+        fuidIndex.emplace(tensor->getFuid(), tensor);
         tensors.emplace_back(tensor);
+        memoryPlans.clear();
         return tensor;
     }
 
@@ -323,36 +875,34 @@ namespace infini
     // "predecessors" and "successors" of an operator of "ops" must be in "ops".
     bool GraphObj::checkValid() const
     {
-        for (auto tensor : tensors)
+        for (auto tensor : getTensors())
         {
             IT_ASSERT(!(tensor->getTargets().size() == 0 &&
                         nullptr == tensor->getSource()));
             for (auto op : tensor->getTargets())
             {
-                IT_ASSERT(std::find(ops.begin(), ops.end(), op) != ops.end());
+                IT_ASSERT(hasOperator(op));
             }
             auto op = tensor->getSource();
-            IT_ASSERT(!(op && std::find(ops.begin(), ops.end(), op) == ops.end()));
+            IT_ASSERT(!(op && !hasOperator(op)));
         }
-        for (auto op : ops)
+        for (auto op : getOperators())
         {
             for (auto tensor : op->getInputs())
             {
-                IT_ASSERT(std::find(tensors.begin(), tensors.end(), tensor) !=
-                          tensors.end());
+                IT_ASSERT(hasTensor(tensor));
             }
             for (auto tensor : op->getOutputs())
             {
-                IT_ASSERT(std::find(tensors.begin(), tensors.end(), tensor) !=
-                          tensors.end());
+                IT_ASSERT(hasTensor(tensor));
             }
             for (auto pre : op->getPredecessors())
             {
-                IT_ASSERT(std::find(ops.begin(), ops.end(), pre) != ops.end());
+                IT_ASSERT(hasOperator(pre));
             }
             for (auto suc : op->getSuccessors())
             {
-                IT_ASSERT(std::find(ops.begin(), ops.end(), suc) != ops.end());
+                IT_ASSERT(hasOperator(suc));
             }
         }
         std::set<UidBaseType> s;
@@ -366,4 +916,4 @@ namespace infini
         return true;
     }
 
-} // namespace infini
\ No newline at end of file
+} // namespace infini
@@ -0,0 +1,322 @@
+#include "core/graph_json.h"
+#include "operators/concat.h"
+#include "operators/element_wise.h"
+#include "operators/fused_element_wise.h"
+#include "operators/unary.h"
+#include <nlohmann/json.hpp>
+
+namespace infini
+{
+    using json = nlohmann::json;
+
+    namespace
+    {
+        DataType dataTypeFromName(const string &name)
+        {
+            for (int i = 0; i < int(std::size(DataType::names)); ++i)
+                if (DataType::names[i] == name && DataType(i).getSize() > 0)
+                    return DataType(i);
+            IT_TODO_HALT_MSG("Unknown data type " + name);
+        }
+
+        // Cast types are written by name, so the file does not depend on the
+        // order of the enum
+        constexpr std::pair<CastType, std::string_view> castTypeNames[] = {
+            {CastType::Float2Float16, "Float2Float16"},
+            {CastType::Float2Int64, "Float2Int64"},
+            {CastType::Float2Int32, "Float2Int32"},
+            {CastType::Float2Int16, "Float2Int16"},
+            {CastType::Float2Int8, "Float2Int8"},
+            {CastType::Float2BFloat16, "Float2BFloat16"},
+            {CastType::Int322Float, "Int322Float"},
+            {CastType::Int322Int8, "Int322Int8"},
+            {CastType::Int322Int16, "Int322Int16"},
+            {CastType::Int322Int64, "Int322Int64"},
+            {CastType::Int162Float, "Int162Float"},
+            {CastType::Int162Int32, "Int162Int32"},
+            {CastType::Int82Float, "Int82Float"},
+            {CastType::Int82Int16, "Int82Int16"},
+            {CastType::Int82Int32, "Int82Int32"},
+            {CastType::Uint82Float, "Uint82Float"},
+            {CastType::Uint82Int32, "Uint82Int32"},
+            {CastType::Uint82Int64, "Uint82Int64"},
+            {CastType::Int642Int32, "Int642Int32"},
+            {CastType::Int642Uint32, "Int642Uint32"},
+            {CastType::Int642Float, "Int642Float"},
+            {CastType::Uint322Int64, "Uint322Int64"},
+            {CastType::Float162Float, "Float162Float"},
+            {CastType::BFloat162Float, "BFloat162Float"},
+            {CastType::Float2Float, "Float2Float"},
+        };
+
+        string castTypeName(CastType type)
+        {
+            for (const auto &[value, name] : castTypeNames)
+                if (value == type)
+                    return string(name);
+            IT_TODO_HALT_MSG("Unknown cast type " +
+                             std::to_string(int(type)));
+        }
+
+        CastType castTypeFromName(const string &name)
+        {
+            for (const auto &[value, castName] : castTypeNames)
+                if (castName == name)
+                    return value;
+            IT_TODO_HALT_MSG("Unknown cast type " + name);
+        }
+
+        OpType opTypeFromName(const string &name)
+        {
+            for (OpType::underlying_t i = OpType::Add;
+                 i <= OpType::FusedElementWise; ++i)
+                if (name == OpType(i).toString())
+                    return OpType(i);
+            IT_TODO_HALT_MSG("Unknown operator type " + name);
+        }
+
+        void putBound(json &j, const char *key, std::optional<float> val)
+        {
+            if (val)
+                j[key] = *val;
+        }
+
+        std::optional<float> getBound(const json &j, const char *key)
+        {
+            if (!j.contains(key))
+                return std::nullopt;
+            return j.at(key).get<float>();
+        }
+
+        json attributes(const Operator &op)
+        {
+            json j = json::object();
+            switch (op->getOpType().underlying())
+            {
+            case OpType::Clip:
+            {
+                auto clip = as<ClipObj>(op);
+                putBound(j, "min", clip->getMin());
+                putBound(j, "max", clip->getMax());
+                break;
+            }
+            case OpType::Cast:
+                j["castType"] = castTypeName(as<CastObj>(op)->getType());
+                break;
+            case OpType::Concat:
+                j["dim"] = as<ConcatObj>(op)->getDim();
+                break;
+            case OpType::Transpose:
+                j["perm"] = as<TransposeObj>(op)->getPermute();
+                break;
+            case OpType::MatMul:
+            {
+                auto matmul = as<MatmulObj>(op);
+                j["transA"] = matmul->getTransA();
+                j["transB"] = matmul->getTransB();
+                putBound(j, "min", matmul->getMin());
+                putBound(j, "max", matmul->getMax());
+                if (const auto &quant = matmul->getQuantization())
+                    j["quant"] = {{"scaleA", quant->scaleA},
+                                  {"zeroA", quant->zeroA},
+                                  {"scaleB", quant->scaleB},
+                                  {"outType", quant->outType.toString()},
+                                  {"scaleC", quant->scaleC},
+                                  {"zeroC", quant->zeroC}};
+                break;
+            }
+            case OpType::FusedElementWise:
+            {
+                json steps = json::array();
+                for (const auto &step : as<FusedElementWiseObj>(op)->getSteps())
+                {
+                    json s = {{"type", step.type.toString()},
+                              {"lhs", step.lhs},
+                              {"rhs", step.rhs}};
+                    putBound(s, "min", step.min);
+                    putBound(s, "max", step.max);
+                    steps.push_back(s);
+                }
+                j["steps"] = steps;
+                break;
+            }
+            case OpType::Add:
+            case OpType::Sub:
+            case OpType::Mul:
+            case OpType::Div:
+            case OpType::Relu:
+                break;
+            default:
+                IT_TODO_HALT_MSG(string("Cannot export operator ") +
+                                 op->getOpType().toString());
+            }
+            return j;
+        }
+
+        void addOperator(const Graph &g, OpType type, const TensorVec &inputs,
+                         const Tensor &output, const json &j)
+        {
+            auto input = [&](size_t i)
+            {
+                IT_ASSERT(i < inputs.size(), string("Missing input of ") +
+                                                 type.toString());
+                return inputs[i];
+            };
+            switch (type.underlying())
+            {
+            case OpType::Add:
+                g->addOpWithOutputs<AddObj>(input(0), input(1), output);
+                break;
+            case OpType::Sub:
+                g->addOpWithOutputs<SubObj>(input(0), input(1), output);
+                break;
+            case OpType::Mul:
+                g->addOpWithOutputs<MulObj>(input(0), input(1), output);
+                break;
+            case OpType::Div:
+                g->addOpWithOutputs<DivObj>(input(0), input(1), output);
+                break;
+            case OpType::Relu:
+                g->addOpWithOutputs<ReluObj>(input(0), output);
+                break;
+            case OpType::Clip:
+                g->addOpWithOutputs<ClipObj>(input(0), output, getBound(j, "min"),
+                                             getBound(j, "max"));
+                break;
+            case OpType::Cast:
+                g->addOpWithOutputs<CastObj>(
+                    input(0), output,
+                    castTypeFromName(j.at("castType").get<string>()));
+                break;
+            case OpType::Concat:
+                g->addOpWithOutputs<ConcatObj>(inputs, output,
+                                               j.at("dim").get<int>());
+                break;
+            case OpType::Transpose:
+                g->addOpWithOutputs<TransposeObj>(
+                    input(0), output, j.at("perm").get<vector<int>>());
+                break;
+            case OpType::MatMul:
+            {
+                std::optional<MatmulQuantization> quant;
+                if (j.contains("quant"))
+                {
+                    const auto &q = j.at("quant");
+                    quant.emplace();
+                    quant->scaleA = q.at("scaleA").get<float>();
+                    quant->zeroA = q.at("zeroA").get<int32_t>();
+                    quant->scaleB = q.at("scaleB").get<vector<float>>();
+                    quant->outType =
+                        dataTypeFromName(q.at("outType").get<string>());
+                    quant->scaleC = q.at("scaleC").get<float>();
+                    quant->zeroC = q.at("zeroC").get<int32_t>();
+                }
+                auto matmul = g->addOpWithOutputs<MatmulObj>(
+                    input(0), input(1), output, j.value("transA", false),
+                    j.value("transB", false),
+                    inputs.size() > 2 ? inputs[2] : nullptr, quant);
+                matmul->clampOutput(getBound(j, "min"), getBound(j, "max"));
+                break;
+            }
+            case OpType::FusedElementWise:
+            {
+                vector<FusedElementWiseObj::Step> steps;
+                for (const auto &s : j.at("steps"))
+                    steps.push_back({opTypeFromName(s.at("type").get<string>()),
+                                     s.at("lhs").get<int>(),
+                                     s.value("rhs", 0), getBound(s, "min"),
+                                     getBound(s, "max")});
+                g->addOpWithOutputs<FusedElementWiseObj>(inputs, output,
+                                                         steps);
+                break;
+            }
+            default:
+                IT_TODO_HALT_MSG(string("Cannot import operator ") +
+                                 type.toString());
+            }
+        }
+    } // namespace
+
+    string graphToJson(const Graph &graph,
+                       const std::unordered_map<Tensor, string> &weights)
+    {
+        IT_ASSERT(graph->topo_sort(), "Cannot export a graph with cycles");
+        std::unordered_map<TensorObj *, int> id;
+        json tensors = json::array();
+        for (const auto &tensor : graph->getTensors())
+        {
+            int i = id.size();
+            id[tensor.get()] = i;
+            json t = {{"id", i},
+                      {"dims", tensor->getDims()},
+                      {"dtype", tensor->getDType().toString()}};
+            auto it = weights.find(tensor);
+            if (it != weights.end())
+                t["weight"] = it->second;
+            tensors.push_back(t);
+        }
+        json ops = json::array();
+        for (const auto &op : graph->getOperators())
+        {
+            json o = {{"type", op->getOpType().toString()}};
+            vector<int> inputs, outputs;
+            for (const auto &input : op->getInputs())
+                inputs.emplace_back(id.at(input.get()));
+            for (const auto &output : op->getOutputs())
+                outputs.emplace_back(id.at(output.get()));
+            o["inputs"] = inputs;
+            o["outputs"] = outputs;
+            auto attrs = attributes(op);
+            if (!attrs.empty())
+                o["attrs"] = attrs;
+            ops.push_back(o);
+        }
+        return json{{"tensors", tensors}, {"ops", ops}}.dump(2);
+    }
+
+    Graph graphFromJson(Runtime runtime, const string &text,
+                        std::unordered_map<string, Tensor> *weights)
+    {
+        try
+        {
+            auto j = json::parse(text);
+            Graph g = make_ref<GraphObj>(runtime);
+            std::unordered_map<int, Tensor> tensors;
+            for (const auto &t : j.at("tensors"))
+            {
+                auto tensor = g->addTensor(
+                    t.at("dims").get<Shape>(),
+                    dataTypeFromName(t.at("dtype").get<string>()));
+                int id = t.at("id").get<int>();
+                IT_ASSERT(tensors.emplace(id, tensor).second,
+                          "Duplicate tensor id " + std::to_string(id));
+                if (weights && t.contains("weight"))
+                    (*weights)[t.at("weight").get<string>()] = tensor;
+            }
+            auto tensorAt = [&](int id)
+            {
+                auto it = tensors.find(id);
+                IT_ASSERT(it != tensors.end(),
+                          "Unknown tensor id " + std::to_string(id));
+                return it->second;
+            };
+            for (const auto &o : j.at("ops"))
+            {
+                TensorVec inputs;
+                for (int id : o.at("inputs").get<vector<int>>())
+                    inputs.emplace_back(tensorAt(id));
+                auto outputs = o.at("outputs").get<vector<int>>();
+                IT_ASSERT(outputs.size() == 1, "Operators have one output");
+                addOperator(g, opTypeFromName(o.at("type").get<string>()),
+                            inputs, tensorAt(outputs[0]),
+                            o.value("attrs", json::object()));
+            }
+            return g;
+        }
+        catch (const json::exception &e)
+        {
+            IT_TODO_HALT_MSG(string("Bad graph JSON: ") + e.what());
+        }
+    }
+
+} // namespace infini
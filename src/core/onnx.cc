@@ -0,0 +1,651 @@
+#include "core/onnx.h"
+#include "operators/concat.h"
+#include "operators/element_wise.h"
+#include "operators/matmul.h"
+#include "operators/transpose.h"
+#include "operators/unary.h"
+#include "utils/mapped_file.h"
+#include "utils/protobuf.h"
+#include <cstring>
+#include <map>
+#include <optional>
+#include <set>
+#include <variant>
+
+namespace infini
+{
+    namespace
+    {
+        // An initializer, Constant output or input data of the model. Data
+        // points into a mapped file or into memory held by owner.
+        struct Constant
+        {
+            DataType dtype = DataType::Undefine;
+            Shape dims;
+            const char *data = nullptr;
+            Ref<void> owner;
+            Tensor tensor; // created on first use as an operator input
+        };
+
+        struct Attribute
+        {
+            float f = 0;
+            int64_t i = 0;
+            std::string_view s, t;
+            vector<int64_t> ints;
+        };
+
+        struct Node
+        {
+            string opType, name;
+            vector<string> inputs, outputs;
+            std::unordered_map<string, Attribute> attrs;
+
+            const Attribute *attr(const string &key) const
+            {
+                auto it = attrs.find(key);
+                return it == attrs.end() ? nullptr : &it->second;
+            }
+            // Input i, or "" if it is absent
+            const string &input(size_t i) const
+            {
+                static const string none;
+                return i < inputs.size() ? inputs[i] : none;
+            }
+        };
+
+        struct ValueInfo
+        {
+            string name;
+            DataType dtype = DataType::Undefine;
+            vector<std::variant<int, string>> dims; // value or symbolic name
+        };
+
+        DataType onnxDataType(int64_t type)
+        {
+            // ONNX TensorProto.DataType shares the numbering of DataType
+            IT_ASSERT(type > 0 && type < 17 && type != 8 &&
+                          DataType(type).getSize() > 0,
+                      "Unsupported ONNX data type " + std::to_string(type));
+            return DataType(type);
+        }
+
+        class Importer
+        {
+            Runtime runtime;
+            string dir; // of the model, for external data
+            Ref<MappedFile> model;
+            std::map<string, Ref<MappedFile>> externalFiles;
+            std::unordered_map<string, Constant> constants;
+            std::unordered_map<string, Tensor> values;
+            Graph g;
+
+        public:
+            Importer(Runtime runtime, const string &path)
+                : runtime(runtime), g(make_ref<GraphObj>(runtime))
+            {
+                auto slash = path.rfind('/');
+                dir = slash == string::npos ? "" : path.substr(0, slash + 1);
+                model = make_ref<MappedFile>(path);
+            }
+
+            Graph import(std::unordered_map<string, Tensor> *tensors,
+                         const std::unordered_map<string, int> &dimValues);
+
+        private:
+            Constant parseTensor(std::string_view bytes, string *name);
+            Node parseNode(std::string_view bytes);
+            ValueInfo parseValueInfo(std::string_view bytes);
+            const char *externalData(const std::map<string, string> &info,
+                                     size_t bytes, Ref<void> &owner);
+
+            Tensor value(const string &name);
+            const Constant &constant(const Node &node, size_t i);
+            float scalar(const Node &node, size_t i);
+            void addNode(const Node &node);
+        };
+
+        Constant Importer::parseTensor(std::string_view bytes, string *name)
+        {
+            Constant c;
+            std::string_view raw;
+            vector<double> values; // float, int32 and double data
+            vector<uint64_t> wide; // int64 and uint64 data
+            bool external = false;
+            std::map<string, string> externalInfo;
+            ProtoReader r(bytes);
+            for (uint32_t field; (field = r.next());)
+            {
+                switch (field)
+                {
+                case 1:
+                    r.repeated([](ProtoReader &p) { return p.int64(); },
+                               [&](int64_t d) { c.dims.emplace_back(d); });
+                    break;
+                case 2:
+                    c.dtype = onnxDataType(r.int64());
+                    break;
+                case 4:
+                    r.repeated([](ProtoReader &p) { return p.fixed<float>(); },
+                               [&](float v) { values.emplace_back(v); });
+                    break;
+                case 5:
+                    r.repeated(
+                        [](ProtoReader &p) { return int32_t(p.varint()); },
+                        [&](int32_t v) { values.emplace_back(v); });
+                    break;
+                case 7:
+                case 11:
+                    r.repeated([](ProtoReader &p) { return p.varint(); },
+                               [&](uint64_t v) { wide.emplace_back(v); });
+                    break;
+                case 8:
+                    *name = r.bytes();
+                    break;
+                case 9:
+                    raw = r.bytes();
+                    break;
+                case 10:
+                    r.repeated([](ProtoReader &p) { return p.fixed<double>(); },
+                               [&](double v) { values.emplace_back(v); });
+                    break;
+                case 13:
+                {
+                    ProtoReader entry(r.bytes());
+                    string key, val;
+                    for (uint32_t f; (f = entry.next());)
+                        if (f == 1)
+                            key = entry.bytes();
+                        else if (f == 2)
+                            val = entry.bytes();
+                        else
+                            entry.skip();
+                    externalInfo[key] = val;
+                    break;
+                }
+                case 14:
+                    external = r.varint() == 1;
+                    break;
+                default:
+                    r.skip();
+                }
+            }
+            IT_ASSERT(!(c.dtype == DataType::Undefine),
+                      "ONNX tensor " + *name + " has no data type");
+            size_t count = 1;
+            for (auto d : c.dims)
+                count *= d;
+            size_t elemSize = c.dtype.getSize();
+            size_t size = count * elemSize;
+
+            if (external)
+            {
+                c.data = externalData(externalInfo, size, c.owner);
+            }
+            else if (!raw.empty() || (values.empty() && wide.empty()))
+            {
+                IT_ASSERT(raw.size() == size,
+                          "Bad raw data size of ONNX tensor " + *name);
+                c.data = raw.data();
+                c.owner = model;
+            }
+            if (c.data && reinterpret_cast<uintptr_t>(c.data) % elemSize == 0)
+                return c;
+
+            // Unaligned raw data is copied, typed data is converted
+            auto buffer = std::make_shared<vector<uint64_t>>((size + 7) / 8);
+            auto dst = reinterpret_cast<char *>(buffer->data());
+            if (c.data)
+            {
+                std::memcpy(dst, c.data, size);
+            }
+            else
+            {
+                size_t n = values.empty() ? wide.size() : values.size();
+                IT_ASSERT(n == count, "Bad data size of ONNX tensor " + *name);
+                for (size_t i = 0; i < n; ++i)
+                {
+                    double v = values.empty() ? double(int64_t(wide[i]))
+                                              : values[i];
+#define STORE(N)                                                           \
+    if (c.dtype == DataType(N))                                            \
+    {                                                                      \
+        /* int32_data holds the bits of half and bfloat16 */              \
+        reinterpret_cast<DT<N>::t *>(dst)[i] = (DT<N>::t)v;                \
+        continue;                                                          \
+    }
+                    if (elemSize == 8 && !wide.empty())
+                    {
+                        // int64 and uint64 are kept exact
+                        reinterpret_cast<uint64_t *>(dst)[i] = wide[i];
+                        continue;
+                    }
+                    STORE(1) STORE(2) STORE(3) STORE(4) STORE(5) STORE(6)
+                    STORE(7) STORE(9) STORE(10) STORE(11) STORE(12)
+                    STORE(13) STORE(16)
+#undef STORE
+                    IT_TODO_HALT();
+                }
+            }
+            c.data = dst;
+            c.owner = buffer;
+            return c;
+        }
+
+        const char *Importer::externalData(
+            const std::map<string, string> &info, size_t bytes,
+            Ref<void> &owner)
+        {
+            auto location = info.find("location");
+            IT_ASSERT(location != info.end(),
+                      "ONNX external data without a location");
+            size_t offset = 0;
+            if (auto it = info.find("offset"); it != info.end())
+                offset = std::stoull(it->second);
+            if (auto it = info.find("length"); it != info.end())
+                IT_ASSERT(std::stoull(it->second) == bytes,
+                          "Bad length of ONNX external data");
+            auto &file = externalFiles[location->second];
+            if (!file)
+                file = make_ref<MappedFile>(dir + location->second);
+            IT_ASSERT(offset <= file->size() && bytes <= file->size() - offset,
+                      "ONNX external data beyond " + location->second);
+            owner = file;
+            return file->data() + offset;
+        }
+
+        Node Importer::parseNode(std::string_view bytes)
+        {
+            Node node;
+            ProtoReader r(bytes);
+            for (uint32_t field; (field = r.next());)
+            {
+                switch (field)
+                {
+                case 1:
+                    node.inputs.emplace_back(r.bytes());
+                    break;
+                case 2:
+                    node.outputs.emplace_back(r.bytes());
+                    break;
+                case 3:
+                    node.name = r.bytes();
+                    break;
+                case 4:
+                    node.opType = r.bytes();
+                    break;
+                case 5:
+                {
+                    Attribute attr;
+                    string name;
+                    ProtoReader a(r.bytes());
+                    for (uint32_t f; (f = a.next());)
+                    {
+                        if (f == 1)
+                            name = a.bytes();
+                        else if (f == 2)
+                            attr.f = a.fixed<float>();
+                        else if (f == 3)
+                            attr.i = a.int64();
+                        else if (f == 4)
+                            attr.s = a.bytes();
+                        else if (f == 5)
+                            attr.t = a.bytes();
+                        else if (f == 8)
+                            a.repeated([](ProtoReader &p) { return p.int64(); },
+                                       [&](int64_t v)
+                                       { attr.ints.emplace_back(v); });
+                        else
+                            a.skip();
+                    }
+                    node.attrs[name] = attr;
+                    break;
+                }
+                default:
+                    r.skip();
+                }
+            }
+            return node;
+        }
+
+        ValueInfo Importer::parseValueInfo(std::string_view bytes)
+        {
+            ValueInfo info;
+            ProtoReader r(bytes);
+            for (uint32_t field; (field = r.next());)
+            {
+                if (field == 1)
+                {
+                    info.name = r.bytes();
+                    continue;
+                }
+                if (field != 2)
+                {
+                    r.skip();
+                    continue;
+                }
+                ProtoReader type(r.bytes());
+                for (uint32_t f; (f = type.next());)
+                {
+                    if (f != 1) // tensor_type
+                    {
+                        type.skip();
+                        continue;
+                    }
+                    ProtoReader tensor(type.bytes());
+                    for (uint32_t t; (t = tensor.next());)
+                    {
+                        if (t == 1)
+                        {
+                            info.dtype = onnxDataType(tensor.int64());
+                            continue;
+                        }
+                        if (t != 2)
+                        {
+                            tensor.skip();
+                            continue;
+                        }
+                        ProtoReader shape(tensor.bytes());
+                        for (uint32_t s; (s = shape.next());)
+                        {
+                            if (s != 1)
+                            {
+                                shape.skip();
+                                continue;
+                            }
+                            ProtoReader dim(shape.bytes());
+                            std::variant<int, string> value = string();
+                            for (uint32_t d; (d = dim.next());)
+                                if (d == 1)
+                                    value = int(dim.int64());
+                                else if (d == 2)
+                                    value = string(dim.bytes());
+                                else
+                                    dim.skip();
+                            info.dims.emplace_back(value);
+                        }
+                    }
+                }
+            }
+            return info;
+        }
+
+        Tensor Importer::value(const string &name)
+        {
+            if (auto it = values.find(name); it != values.end())
+                return it->second;
+            auto it = constants.find(name);
+            IT_ASSERT(it != constants.end(),
+                      "ONNX value " + name + " is used before it is produced");
+            auto &c = it->second;
+            c.tensor = g->addTensor(c.dims, c.dtype);
+            c.tensor->setDataBlob(make_ref<BlobObj>(
+                runtime, const_cast<char *>(c.data), c.owner));
+            c.tensor->setConstant();
+            return values[name] = c.tensor;
+        }
+
+        const Constant &Importer::constant(const Node &node, size_t i)
+        {
+            auto it = constants.find(node.input(i));
+            IT_ASSERT(it != constants.end(),
+                      node.opType + " " + node.name + " needs input " +
+                          std::to_string(i) + " to be a constant");
+            return it->second;
+        }
+
+        float Importer::scalar(const Node &node, size_t i)
+        {
+            const auto &c = constant(node, i);
+            IT_ASSERT(c.dtype == DataType::Float32 && c.dims.size() <= 1 &&
+                          (c.dims.empty() || c.dims[0] == 1),
+                      node.opType + " " + node.name + " needs input " +
+                          std::to_string(i) + " to be a float scalar");
+            float val;
+            std::memcpy(&val, c.data, sizeof(val));
+            return val;
+        }
+
+        // Cast types by their source and destination data types
+        const vector<std::tuple<DataType, DataType, CastType>> castTypes = {
+            {DataType::Float32, DataType::Float16, CastType::Float2Float16},
+            {DataType::Float32, DataType::Int64, CastType::Float2Int64},
+            {DataType::Float32, DataType::Int32, CastType::Float2Int32},
+            {DataType::Float32, DataType::Int16, CastType::Float2Int16},
+            {DataType::Float32, DataType::Int8, CastType::Float2Int8},
+            {DataType::Float32, DataType::BFloat16, CastType::Float2BFloat16},
+            {DataType::Int32, DataType::Float32, CastType::Int322Float},
+            {DataType::Int32, DataType::Int8, CastType::Int322Int8},
+            {DataType::Int32, DataType::Int16, CastType::Int322Int16},
+            {DataType::Int32, DataType::Int64, CastType::Int322Int64},
+            {DataType::Int16, DataType::Float32, CastType::Int162Float},
+            {DataType::Int16, DataType::Int32, CastType::Int162Int32},
+            {DataType::Int8, DataType::Float32, CastType::Int82Float},
+            {DataType::Int8, DataType::Int16, CastType::Int82Int16},
+            {DataType::Int8, DataType::Int32, CastType::Int82Int32},
+            {DataType::UInt8, DataType::Float32, CastType::Uint82Float},
+            {DataType::UInt8, DataType::Int32, CastType::Uint82Int32},
+            {DataType::UInt8, DataType::Int64, CastType::Uint82Int64},
+            {DataType::Int64, DataType::Int32, CastType::Int642Int32},
+            {DataType::Int64, DataType::UInt32, CastType::Int642Uint32},
+            {DataType::Int64, DataType::Float32, CastType::Int642Float},
+            {DataType::UInt32, DataType::Int64, CastType::Uint322Int64},
+            {DataType::Float16, DataType::Float32, CastType::Float162Float},
+            {DataType::BFloat16, DataType::Float32, CastType::BFloat162Float},
+        };
+
+        const std::set<string> supportedOps = {
+            "Add",  "Sub",  "Mul",  "Div",    "MatMul",    "Gemm",     "Relu",
+            "Clip", "Cast", "Concat", "Transpose", "Constant", "Identity"};
+
+        void Importer::addNode(const Node &node)
+        {
+            const auto &type = node.opType;
+            IT_ASSERT(node.outputs.size() == 1,
+                      type + " " + node.name + " must have one output");
+            const auto &out = node.outputs[0];
+            auto in = [&](size_t i) { return value(node.input(i)); };
+            auto rank = [&](size_t i) { return (int)in(i)->getRank(); };
+            Tensor result;
+            if (type == "Constant")
+            {
+                auto attr = node.attr("value");
+                IT_ASSERT(attr && !attr->t.empty(),
+                          "Constant " + node.name + " needs a tensor value");
+                string name;
+                constants[out] = parseTensor(attr->t, &name);
+                return;
+            }
+            if (type == "Identity")
+            {
+                if (!values.count(node.input(0)) &&
+                    constants.count(node.input(0)))
+                    constants[out] = constants[node.input(0)];
+                else
+                    values[out] = in(0);
+                return;
+            }
+            if (type == "Add")
+                result = g->addOp<AddObj>(in(0), in(1), nullptr)->getOutput();
+            else if (type == "Sub")
+                result = g->addOp<SubObj>(in(0), in(1), nullptr)->getOutput();
+            else if (type == "Mul")
+                result = g->addOp<MulObj>(in(0), in(1), nullptr)->getOutput();
+            else if (type == "Div")
+                result = g->addOp<DivObj>(in(0), in(1), nullptr)->getOutput();
+            else if (type == "Relu")
+                result = g->addOp<ReluObj>(in(0), nullptr)->getOutput();
+            else if (type == "Clip")
+            {
+                // Bounds are attributes before opset 11, optional inputs since
+                std::optional<float> min, max;
+                if (auto attr = node.attr("min"))
+                    min = attr->f;
+                if (auto attr = node.attr("max"))
+                    max = attr->f;
+                if (!node.input(1).empty())
+                    min = scalar(node, 1);
+                if (!node.input(2).empty())
+                    max = scalar(node, 2);
+                result = g->addOp<ClipObj>(in(0), nullptr, min, max)
+                             ->getOutput();
+            }
+            else if (type == "Cast")
+            {
+                auto attr = node.attr("to");
+                IT_ASSERT(attr, "Cast " + node.name + " has no target type");
+                auto from = in(0)->getDType(), to = onnxDataType(attr->i);
+                if (from == to)
+                {
+                    values[out] = in(0);
+                    return;
+                }
+                auto it = std::find_if(castTypes.begin(), castTypes.end(),
+                                       [&](const auto &c)
+                                       {
+                                           return std::get<0>(c) == from &&
+                                                  std::get<1>(c) == to;
+                                       });
+                IT_ASSERT(it != castTypes.end(),
+                          "Unsupported Cast from " + from.toString() + " to " +
+                              to.toString());
+                result = g->addOp<CastObj>(in(0), nullptr, std::get<2>(*it))
+                             ->getOutput();
+            }
+            else if (type == "Concat")
+            {
+                auto attr = node.attr("axis");
+                IT_ASSERT(attr, "Concat " + node.name + " has no axis");
+                TensorVec inputs;
+                for (size_t i = 0; i < node.inputs.size(); ++i)
+                    inputs.emplace_back(in(i));
+                int axis = attr->i < 0 ? attr->i + rank(0) : attr->i;
+                result =
+                    g->addOp<ConcatObj>(inputs, nullptr, axis)->getOutput();
+            }
+            else if (type == "Transpose")
+            {
+                vector<int> perm;
+                if (auto attr = node.attr("perm"))
+                    perm.assign(attr->ints.begin(), attr->ints.end());
+                else
+                    for (int i = rank(0) - 1; i >= 0; --i)
+                        perm.emplace_back(i);
+                result = g->addOp<TransposeObj>(in(0), nullptr, perm)
+                             ->getOutput();
+            }
+            else if (type == "MatMul" || type == "Gemm")
+            {
+                IT_ASSERT(rank(0) >= 2 && rank(1) >= 2,
+                          type + " " + node.name +
+                              ": 1-D operands are not supported");
+                bool transA = false, transB = false;
+                Tensor bias;
+                if (type == "Gemm")
+                {
+                    auto attr = [&](const char *key, float def)
+                    {
+                        auto a = node.attr(key);
+                        return a ? (a->f != 0 ? a->f : float(a->i)) : def;
+                    };
+                    transA = attr("transA", 0) != 0;
+                    transB = attr("transB", 0) != 0;
+                    IT_ASSERT(attr("alpha", 1) == 1 &&
+                                  (node.input(2).empty() ||
+                                   attr("beta", 1) == 1),
+                              "Gemm " + node.name +
+                                  ": only alpha = beta = 1 is supported");
+                    if (!node.input(2).empty())
+                        bias = in(2);
+                }
+                result = g->addOp<MatmulObj>(in(0), in(1), nullptr, transA,
+                                             transB, bias)
+                             ->getOutput();
+            }
+            else
+                IT_TODO_HALT_MSG("Unsupported ONNX operator " + type);
+            values[out] = result;
+        }
+
+        Graph Importer::import(std::unordered_map<string, Tensor> *tensors,
+                               const std::unordered_map<string, int> &dimValues)
+        {
+            std::string_view graph;
+            ProtoReader m(model->data(), model->size());
+            for (uint32_t field; (field = m.next());)
+                if (field == 7)
+                    graph = m.bytes();
+                else
+                    m.skip();
+            IT_ASSERT(!graph.empty(), "ONNX model has no graph");
+
+            vector<Node> nodes;
+            vector<ValueInfo> inputs;
+            ProtoReader r(graph);
+            for (uint32_t field; (field = r.next());)
+            {
+                if (field == 1)
+                    nodes.emplace_back(parseNode(r.bytes()));
+                else if (field == 5)
+                {
+                    string name;
+                    auto c = parseTensor(r.bytes(), &name);
+                    constants[name] = c;
+                }
+                else if (field == 11)
+                    inputs.emplace_back(parseValueInfo(r.bytes()));
+                else
+                    r.skip();
+            }
+
+            // Report every unsupported operator at once
+            std::map<string, int> unsupported;
+            for (const auto &node : nodes)
+                if (!supportedOps.count(node.opType))
+                    ++unsupported[node.opType];
+            if (!unsupported.empty())
+            {
+                string msg = "Unsupported ONNX operators:";
+                for (const auto &[type, count] : unsupported)
+                    msg += " " + type + " (" + std::to_string(count) +
+                           (count == 1 ? " node)" : " nodes)");
+                IT_TODO_HALT_MSG(msg);
+            }
+
+            for (const auto &input : inputs)
+            {
+                if (constants.count(input.name))
+                    continue; // initializers may be listed as inputs too
+                Shape dims;
+                for (const auto &dim : input.dims)
+                {
+                    if (auto val = std::get_if<int>(&dim))
+                    {
+                        dims.emplace_back(*val);
+                        continue;
+                    }
+                    const auto &param = std::get<string>(dim);
+                    auto it = dimValues.find(param);
+                    IT_ASSERT(it != dimValues.end(),
+                              "Input " + input.name + " has dim '" + param +
+                                  "'; give its value in dimValues");
+                    dims.emplace_back(it->second);
+                }
+                values[input.name] = g->addTensor(dims, input.dtype);
+            }
+            for (const auto &node : nodes)
+                addNode(node);
+            if (tensors)
+                *tensors = values;
+            return g;
+        }
+    } // namespace
+
+    Graph loadOnnx(Runtime runtime, const string &path,
+                   std::unordered_map<string, Tensor> *tensors,
+                   const std::unordered_map<string, int> &dimValues)
+    {
+        return Importer(runtime, path).import(tensors, dimValues);
+    }
+
+} // namespace infini
@@ -21,6 +21,7 @@ namespace infini
             CASE(Transpose);
             CASE(Concat);
             CASE(MatMul);
+            CASE(FusedElementWise);
 
         default:
             return "Unknown";
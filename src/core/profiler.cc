@@ -0,0 +1,170 @@
+#include "core/profiler.h"
+#include "operators/fused_element_wise.h"
+#include "operators/matmul.h"
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <map>
+
+namespace infini
+{
+    KernelFunc Profiler::wrap(const Operator &op, const string &kernel,
+                              KernelFunc launch)
+    {
+        // The record is filled in once; each call only adds the timing.
+        Record proto{op->getGuid(), op->getOpType(), kernel, 0, 0,
+                     countFlops(op), countBytes(op), 0};
+        return [self = shared_from_this(), proto, launch = std::move(launch)]()
+        {
+            auto begin = Clock::now();
+            launch();
+            auto end = Clock::now();
+            auto thread = std::this_thread::get_id();
+            std::lock_guard<std::mutex> lock(self->mutex);
+            Record record = proto;
+            record.begin = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                               begin - self->origin)
+                               .count();
+            record.duration =
+                std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin)
+                    .count();
+            auto &threads = self->threads;
+            record.thread =
+                threads.emplace(thread, (int)threads.size()).first->second;
+            self->records.emplace_back(std::move(record));
+        };
+    }
+
+    vector<Profiler::Record> Profiler::getRecords() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return records;
+    }
+
+    vector<Profiler::Summary> Profiler::summarize() const
+    {
+        std::map<std::pair<OpType::underlying_t, string>, Summary> totals;
+        for (const auto &r : getRecords())
+        {
+            auto &s = totals
+                          .try_emplace({r.type.underlying(), r.kernel},
+                                       Summary{r.type, r.kernel, 0, 0, 0, 0})
+                          .first->second;
+            ++s.calls;
+            s.seconds += r.duration * 1e-9;
+            s.flops += r.flops;
+            s.bytes += r.bytes;
+        }
+        vector<Summary> summaries;
+        for (auto &[key, s] : totals)
+            summaries.emplace_back(s);
+        std::stable_sort(summaries.begin(), summaries.end(),
+                         [](const Summary &a, const Summary &b)
+                         { return a.seconds > b.seconds; });
+        return summaries;
+    }
+
+    void Profiler::clear()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        records.clear();
+        threads.clear();
+        origin = Clock::now();
+    }
+
+    void Profiler::printSummary(std::ostream &os) const
+    {
+        auto summaries = summarize();
+        double total = 0;
+        for (const auto &s : summaries)
+            total += s.seconds;
+        auto flags = os.flags();
+        os << std::fixed << std::setprecision(3) << std::left << std::setw(18)
+           << "op" << std::setw(24) << "kernel" << std::right << std::setw(8)
+           << "calls" << std::setw(12) << "total ms" << std::setw(8) << "%"
+           << std::setw(12) << "GFLOP/s" << std::setw(10) << "GB/s" << "\n";
+        for (const auto &s : summaries)
+        {
+            os << std::left << std::setw(18) << s.type.toString()
+               << std::setw(24) << s.kernel << std::right << std::setw(8)
+               << s.calls << std::setw(12) << s.seconds * 1e3 << std::setw(8)
+               << std::setprecision(1)
+               << (total > 0 ? 100 * s.seconds / total : 0.)
+               << std::setprecision(3) << std::setw(12)
+               << (s.seconds > 0 ? s.flops / s.seconds * 1e-9 : 0.)
+               << std::setw(10)
+               << (s.seconds > 0 ? s.bytes / s.seconds * 1e-9 : 0.) << "\n";
+        }
+        os.flags(flags);
+    }
+
+    void Profiler::writeChromeTrace(std::ostream &os) const
+    {
+        // Complete ("X") events with microsecond timestamps, one track per
+        // thread that ran operators.
+        auto all = getRecords();
+        auto flags = os.flags();
+        os << std::fixed << std::setprecision(3) << "{\"traceEvents\": [";
+        for (size_t i = 0; i < all.size(); ++i)
+        {
+            const auto &r = all[i];
+            os << (i ? "," : "") << "\n  {\"name\": \"" << r.type.toString()
+               << "\", \"cat\": \"" << r.kernel
+               << "\", \"ph\": \"X\", \"pid\": 0, \"tid\": " << r.thread
+               << ", \"ts\": " << r.begin * 1e-3
+               << ", \"dur\": " << r.duration * 1e-3
+               << ", \"args\": {\"guid\": " << r.guid
+               << ", \"flops\": " << r.flops << ", \"bytes\": " << r.bytes
+               << "}}";
+        }
+        os << "\n], \"displayTimeUnit\": \"ms\"}\n";
+        os.flags(flags);
+    }
+
+    void Profiler::saveChromeTrace(const string &path) const
+    {
+        std::ofstream file(path);
+        IT_ASSERT(file.good(), "Cannot open " + path);
+        writeChromeTrace(file);
+        IT_ASSERT(file.good(), "Cannot write " + path);
+    }
+
+    double Profiler::countFlops(const Operator &op)
+    {
+        double outputs = 0;
+        for (const auto &output : op->getOutputs())
+            outputs += output->size();
+        switch (op->getOpType().underlying())
+        {
+        case OpType::MatMul:
+        {
+            auto matmul = as<MatmulObj>(op);
+            // a multiply and an add per product, plus the bias
+            return 2 * outputs * matmul->getK() +
+                   (matmul->getBias() ? outputs : 0);
+        }
+        case OpType::Add:
+        case OpType::Sub:
+        case OpType::Mul:
+        case OpType::Div:
+        case OpType::Relu:
+        case OpType::Clip:
+            return outputs;
+        case OpType::FusedElementWise:
+            return outputs * as<FusedElementWiseObj>(op)->getSteps().size();
+        default:
+            return 0;
+        }
+    }
+
+    double Profiler::countBytes(const Operator &op)
+    {
+        double bytes = 0;
+        for (const auto &input : op->getInputs())
+            bytes += input->getBytes();
+        for (const auto &output : op->getOutputs())
+            bytes += output->getBytes();
+        return bytes;
+    }
+
+} // namespace infini
@@ -3,9 +3,15 @@
 #include "core/kernel.h"
 #include "core/graph.h"
 #include "core/kernel.h"
+#include "core/profiler.h"
+#include "utils/thread_pool.h"
 #include <chrono>
 #include <cstring>
+#include <exception>
 #include <memory>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 namespace infini
 {
     void NativeCpuRuntimeObj::run(const Graph &graph) const
@@ -16,10 +22,204 @@ namespace infini
         {
             auto kernelAttrs = KernelAttrs{device, op->getOpType().underlying()};
             Kernel *kernel = kernelRegistry.getKernel(kernelAttrs);
-            kernel->compute(op, this);
+            if (profiler)
+            {
+                const auto &name =
+                    std::get<1>(kernelRegistry.getKernelItem(kernelAttrs));
+                profiler->wrap(op, name, [&]()
+                               { kernel->compute(op, this); })();
+            }
+            else
+                kernel->compute(op, this);
         }
     }
 
+    ExecutionPlan NativeCpuRuntimeObj::compile(const Graph &graph) const
+    {
+        const auto &kernelRegistry = KernelRegistry::getInstance();
+
+        const auto &ops = graph->getOperators();
+        ExecutionPlan plan;
+        plan.launches.reserve(ops.size());
+        plan.memory = graph->shareAllocator();
+        for (auto &op : ops)
+        {
+            auto kernelAttrs = KernelAttrs{device, op->getOpType().underlying()};
+            Kernel *kernel = kernelRegistry.getKernel(kernelAttrs);
+            auto launch = kernel->prepare(op, this);
+            if (profiler)
+                launch = profiler->wrap(
+                    op, std::get<1>(kernelRegistry.getKernelItem(kernelAttrs)),
+                    std::move(launch));
+            plan.launches.emplace_back(std::move(launch));
+        }
+
+        // Dependencies: data edges between operators, plus an edge from every
+        // user of a tensor to the producer of any later tensor that reuses its
+        // memory, since the memory plan assumes sequential execution.
+        std::unordered_map<OperatorObj *, size_t> index;
+        for (size_t i = 0; i < ops.size(); ++i)
+            index[ops[i].get()] = i;
+        vector<set<size_t>> successors(ops.size());
+        for (size_t i = 0; i < ops.size(); ++i)
+            for (auto &succ : ops[i]->getSuccessors())
+                successors[i].insert(index.at(succ.get()));
+
+        struct Range
+        {
+            uintptr_t begin, end;
+            // operators touching the tensor, the producer (if any) first
+            vector<size_t> users;
+        };
+        vector<Range> ranges;
+        for (auto &tensor : graph->getTensors())
+        {
+            if (tensor->getBytes() == 0)
+                continue;
+            auto begin =
+                reinterpret_cast<uintptr_t>(tensor->getRawDataPtr<void *>());
+            Range range{begin, begin + tensor->getBytes(), {}};
+            if (auto source = tensor->getSource())
+                range.users.emplace_back(index.at(source.get()));
+            for (auto &target : tensor->getTargets())
+                range.users.emplace_back(index.at(target.get()));
+            if (!range.users.empty())
+                ranges.emplace_back(std::move(range));
+        }
+        std::sort(ranges.begin(), ranges.end(), [](auto &a, auto &b)
+                  { return a.begin < b.begin; });
+        for (size_t i = 0; i < ranges.size(); ++i)
+        {
+            for (size_t j = i + 1;
+                 j < ranges.size() && ranges[j].begin < ranges[i].end; ++j)
+            {
+                const Range *first = &ranges[i], *second = &ranges[j];
+                auto last = [](const Range *r)
+                { return *std::max_element(r->users.begin(), r->users.end()); };
+                if (last(first) > second->users.front())
+                    std::swap(first, second);
+                // Tensors sharing memory whose lifetimes overlap are aliases
+                // of each other, which the data edges already order.
+                if (last(first) > second->users.front())
+                    continue;
+                for (auto user : first->users)
+                    if (user != second->users.front())
+                        successors[user].insert(second->users.front());
+            }
+        }
+
+        plan.successors.resize(ops.size());
+        plan.dependencies.assign(ops.size(), 0);
+        for (size_t i = 0; i < ops.size(); ++i)
+        {
+            plan.successors[i].assign(successors[i].begin(), successors[i].end());
+            for (auto succ : successors[i])
+                ++plan.dependencies[succ];
+        }
+        return plan;
+    }
+
+    void NativeCpuRuntimeObj::run(const ExecutionPlan &plan) const
+    {
+        if (!interOpPool)
+        {
+            for (auto &launch : plan.launches)
+                launch();
+            return;
+        }
+        if (plan.launches.empty())
+            return;
+
+        // Every launch is submitted once all the launches it depends on have
+        // finished; the calling thread waits until all of them are done.
+        struct State
+        {
+            const ExecutionPlan &plan;
+            ThreadPool &pool;
+            std::unique_ptr<std::atomic<int>[]> pending;
+            std::atomic<size_t> remaining;
+            std::mutex mutex;
+            std::condition_variable done;
+            std::exception_ptr error;
+            bool finished = false;
+            std::atomic<bool> failed{false};
+
+            void launch(size_t i)
+            {
+                pool.submit([this, i]()
+                            { execute(i); });
+            }
+
+            void execute(size_t i)
+            {
+                // After a failure the remaining launches are only counted down.
+                if (!failed)
+                {
+                    try
+                    {
+                        plan.launches[i]();
+                    }
+                    catch (...)
+                    {
+                        std::lock_guard<std::mutex> lock(mutex);
+                        if (!error)
+                            error = std::current_exception();
+                        failed = true;
+                    }
+                }
+                for (auto succ : plan.successors[i])
+                    if (--pending[succ] == 0)
+                        launch(succ);
+                if (--remaining == 0)
+                {
+                    // The caller may destroy the state as soon as it sees
+                    // `finished`, so nothing is touched after unlocking.
+                    std::lock_guard<std::mutex> lock(mutex);
+                    finished = true;
+                    done.notify_all();
+                }
+            }
+        };
+        size_t n = plan.launches.size();
+        State state{plan, *interOpPool,
+                    std::make_unique<std::atomic<int>[]>(n), {n}, {}, {}, {}};
+        for (size_t i = 0; i < n; ++i)
+            state.pending[i] = plan.dependencies[i];
+        for (size_t i = 0; i < n; ++i)
+            if (plan.dependencies[i] == 0)
+                state.launch(i);
+        std::unique_lock<std::mutex> lock(state.mutex);
+        state.done.wait(lock, [&]()
+                        { return state.finished; });
+        if (state.error)
+            std::rethrow_exception(state.error);
+    }
+
+    void NativeCpuRuntimeObj::setInterOpThreads(int numWorkers)
+    {
+        if (numWorkers <= 1)
+        {
+            interOpPool = nullptr;
+            return;
+        }
+        int cores = std::thread::hardware_concurrency();
+#ifdef _OPENMP
+        cores = omp_get_max_threads();
+#endif
+        interOpPool = std::make_shared<ThreadPool>(
+            numWorkers, std::max(1, cores / numWorkers));
+    }
+
+    int NativeCpuRuntimeObj::getInterOpThreads() const
+    {
+        return interOpPool ? interOpPool->size() : 1;
+    }
+
+    void NativeCpuRuntimeObj::setProfiler(std::shared_ptr<Profiler> profiler)
+    {
+        this->profiler = std::move(profiler);
+    }
+
     string NativeCpuRuntimeObj::toString() const { return "CPU Runtime"; }
 
     void NativeCpuRuntimeObj::dealloc(void *ptr)
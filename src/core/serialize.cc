@@ -0,0 +1,394 @@
+#include "core/serialize.h"
+#include "operators/concat.h"
+#include "operators/element_wise.h"
+#include "operators/fused_element_wise.h"
+#include "operators/unary.h"
+#include "utils/mapped_file.h"
+
+namespace infini
+{
+    // File layout, all integers and weights in the byte order of the host
+    // that saved the file (weights are mapped as they are, not converted):
+    //   header   magic, version, byte-order mark, tensor and operator counts
+    //   tensors  dtype, rank, dims, then offset and size of the data (0 and
+    //            0 for tensors without data)
+    //   ops      type, input and output tensor indices, attributes
+    //   data     weight blobs, each at a 64-byte aligned file offset
+    namespace
+    {
+        constexpr char magic[8] = {'I', 'T', 'G', 'R', 'A', 'P', 'H', '\0'};
+        constexpr uint32_t version = 1;
+        // Reads back as another value on a host of the other byte order
+        constexpr uint32_t byteOrderMark = 0x01020304;
+        constexpr size_t blobAlignment = 64;
+
+        class Writer
+        {
+            string buf;
+
+        public:
+            template <typename T>
+            void put(const T &val)
+            {
+                static_assert(std::is_trivially_copyable_v<T>);
+                buf.append(reinterpret_cast<const char *>(&val), sizeof(T));
+            }
+            void put(const std::optional<float> &val)
+            {
+                put<uint8_t>(val.has_value());
+                put(val.value_or(0.f));
+            }
+            template <typename T>
+            void putVector(const vector<T> &vals)
+            {
+                put<uint32_t>(vals.size());
+                for (const auto &val : vals)
+                    put(val);
+            }
+            // Reserve a uint64 to be filled in by patch
+            size_t reserve()
+            {
+                put<uint64_t>(0);
+                return buf.size() - sizeof(uint64_t);
+            }
+            void patch(size_t pos, uint64_t val)
+            {
+                std::memcpy(&buf[pos], &val, sizeof(val));
+            }
+            size_t size() const { return buf.size(); }
+            void append(const void *data, size_t bytes)
+            {
+                buf.append(static_cast<const char *>(data), bytes);
+            }
+            const string &data() const { return buf; }
+        };
+
+        class Reader
+        {
+            const char *ptr, *end;
+
+        public:
+            Reader(const char *begin, size_t size)
+                : ptr(begin), end(begin + size) {}
+            template <typename T>
+            T get()
+            {
+                IT_ASSERT(size_t(end - ptr) >= sizeof(T),
+                          "Truncated model file");
+                T val;
+                std::memcpy(&val, ptr, sizeof(T));
+                ptr += sizeof(T);
+                return val;
+            }
+            std::optional<float> getOptional()
+            {
+                bool has = get<uint8_t>();
+                float val = get<float>();
+                return has ? std::optional<float>(val) : std::nullopt;
+            }
+            template <typename T>
+            vector<T> getVector()
+            {
+                auto n = get<uint32_t>();
+                IT_ASSERT(n <= size_t(end - ptr) / sizeof(T),
+                          "Truncated model file");
+                vector<T> vals(n);
+                for (auto &val : vals)
+                    val = get<T>();
+                return vals;
+            }
+        };
+
+        void putAttributes(Writer &w, const Operator &op)
+        {
+            switch (op->getOpType().underlying())
+            {
+            case OpType::Clip:
+            {
+                auto clip = as<ClipObj>(op);
+                w.put(clip->getMin());
+                w.put(clip->getMax());
+                break;
+            }
+            case OpType::Cast:
+                w.put<uint32_t>((uint32_t)as<CastObj>(op)->getType());
+                break;
+            case OpType::Concat:
+                w.put<int32_t>(as<ConcatObj>(op)->getDim());
+                break;
+            case OpType::Transpose:
+                w.putVector(as<TransposeObj>(op)->getPermute());
+                break;
+            case OpType::MatMul:
+            {
+                auto matmul = as<MatmulObj>(op);
+                w.put<uint8_t>(matmul->getTransA());
+                w.put<uint8_t>(matmul->getTransB());
+                w.put(matmul->getMin());
+                w.put(matmul->getMax());
+                const auto &quant = matmul->getQuantization();
+                w.put<uint8_t>(quant.has_value());
+                if (quant)
+                {
+                    w.put(quant->scaleA);
+                    w.put(quant->zeroA);
+                    w.putVector(quant->scaleB);
+                    w.put<int32_t>(quant->outType.getIndex());
+                    w.put(quant->scaleC);
+                    w.put(quant->zeroC);
+                }
+                break;
+            }
+            case OpType::FusedElementWise:
+            {
+                const auto &steps = as<FusedElementWiseObj>(op)->getSteps();
+                w.put<uint32_t>(steps.size());
+                for (const auto &step : steps)
+                {
+                    w.put<uint16_t>(step.type.underlying());
+                    w.put<int32_t>(step.lhs);
+                    w.put<int32_t>(step.rhs);
+                    w.put(step.min);
+                    w.put(step.max);
+                }
+                break;
+            }
+            case OpType::Add:
+            case OpType::Sub:
+            case OpType::Mul:
+            case OpType::Div:
+            case OpType::Relu:
+                break;
+            default:
+                IT_TODO_HALT_MSG(string("Cannot save operator ") +
+                                 op->getOpType().toString());
+            }
+        }
+
+        void readOperator(Reader &r, const Graph &g, OpType type,
+                          const TensorVec &inputs, const Tensor &output)
+        {
+            auto input = [&](size_t i)
+            {
+                IT_ASSERT(i < inputs.size(), "Missing operator input");
+                return inputs[i];
+            };
+            switch (type.underlying())
+            {
+            case OpType::Add:
+                g->addOpWithOutputs<AddObj>(input(0), input(1), output);
+                break;
+            case OpType::Sub:
+                g->addOpWithOutputs<SubObj>(input(0), input(1), output);
+                break;
+            case OpType::Mul:
+                g->addOpWithOutputs<MulObj>(input(0), input(1), output);
+                break;
+            case OpType::Div:
+                g->addOpWithOutputs<DivObj>(input(0), input(1), output);
+                break;
+            case OpType::Relu:
+                g->addOpWithOutputs<ReluObj>(input(0), output);
+                break;
+            case OpType::Clip:
+            {
+                auto min = r.getOptional();
+                auto max = r.getOptional();
+                g->addOpWithOutputs<ClipObj>(input(0), output, min, max);
+                break;
+            }
+            case OpType::Cast:
+                g->addOpWithOutputs<CastObj>(input(0), output,
+                                             (CastType)r.get<uint32_t>());
+                break;
+            case OpType::Concat:
+                g->addOpWithOutputs<ConcatObj>(inputs, output,
+                                               r.get<int32_t>());
+                break;
+            case OpType::Transpose:
+                g->addOpWithOutputs<TransposeObj>(input(0), output,
+                                                  r.getVector<int>());
+                break;
+            case OpType::MatMul:
+            {
+                bool transA = r.get<uint8_t>(), transB = r.get<uint8_t>();
+                auto min = r.getOptional();
+                auto max = r.getOptional();
+                std::optional<MatmulQuantization> quant;
+                if (r.get<uint8_t>())
+                {
+                    quant.emplace();
+                    quant->scaleA = r.get<float>();
+                    quant->zeroA = r.get<int32_t>();
+                    quant->scaleB = r.getVector<float>();
+                    quant->outType = DataType(r.get<int32_t>());
+                    quant->scaleC = r.get<float>();
+                    quant->zeroC = r.get<int32_t>();
+                }
+                auto matmul = g->addOpWithOutputs<MatmulObj>(
+                    input(0), input(1), output, transA, transB,
+                    inputs.size() > 2 ? inputs[2] : nullptr, quant);
+                matmul->clampOutput(min, max);
+                break;
+            }
+            case OpType::FusedElementWise:
+            {
+                vector<FusedElementWiseObj::Step> steps;
+                for (auto n = r.get<uint32_t>(); n > 0; --n)
+                {
+                    OpType stepType(r.get<uint16_t>());
+                    int lhs = r.get<int32_t>(), rhs = r.get<int32_t>();
+                    auto min = r.getOptional();
+                    auto max = r.getOptional();
+                    steps.push_back({stepType, lhs, rhs, min, max});
+                }
+                g->addOpWithOutputs<FusedElementWiseObj>(inputs, output,
+                                                         steps);
+                break;
+            }
+            default:
+                IT_TODO_HALT_MSG("Unsupported operator type " +
+                                 std::to_string(type.underlying()) +
+                                 " in model file");
+            }
+        }
+    } // namespace
+
+    void saveGraph(const Graph &graph, const string &path,
+                   const TensorVec &weights)
+    {
+        IT_ASSERT(graph->topo_sort(), "Cannot save a graph with cycles");
+        const auto &tensors = graph->getTensors();
+        const auto &ops = graph->getOperators();
+        std::unordered_map<TensorObj *, uint32_t> index;
+        for (size_t i = 0; i < tensors.size(); ++i)
+            index[tensors[i].get()] = i;
+        auto indexOf = [&](const Tensor &tensor)
+        {
+            auto it = index.find(tensor.get());
+            IT_ASSERT(it != index.end(), "Tensor is not in the graph");
+            return it->second;
+        };
+
+        Writer w;
+        w.append(magic, sizeof(magic));
+        w.put(version);
+        w.put(byteOrderMark);
+        w.put<uint32_t>(tensors.size());
+        w.put<uint32_t>(ops.size());
+
+        // Data offsets are only known once the records are written
+        std::unordered_map<TensorObj *, size_t> dataField;
+        for (const auto &weight : weights)
+            dataField[weight.get()] = 0;
+        vector<std::pair<size_t, Tensor>> patches;
+        for (const auto &tensor : tensors)
+        {
+            w.put<int32_t>(tensor->getDType().getIndex());
+            w.putVector(tensor->getDims());
+            size_t offsetPos = w.reserve();
+            w.put<uint64_t>(dataField.count(tensor.get()) ? tensor->getBytes()
+                                                          : 0);
+            if (dataField.count(tensor.get()))
+                patches.emplace_back(offsetPos, tensor);
+        }
+        IT_ASSERT(patches.size() == weights.size(),
+                  "Weights must be tensors of the graph");
+
+        for (const auto &op : ops)
+        {
+            w.put<uint16_t>(op->getOpType().underlying());
+            vector<uint32_t> inputs, outputs;
+            for (const auto &input : op->getInputs())
+                inputs.emplace_back(indexOf(input));
+            for (const auto &output : op->getOutputs())
+                outputs.emplace_back(indexOf(output));
+            w.putVector(inputs);
+            w.putVector(outputs);
+            putAttributes(w, op);
+        }
+
+        // The blobs are laid out after the records and streamed to the file
+        // from the tensors, so they are never copied into the buffer
+        vector<size_t> blobOffsets;
+        size_t end = w.size();
+        for (const auto &[pos, tensor] : patches)
+        {
+            size_t offset =
+                (end + blobAlignment - 1) / blobAlignment * blobAlignment;
+            w.patch(pos, offset);
+            blobOffsets.emplace_back(offset);
+            end = offset + tensor->getBytes();
+        }
+
+        std::ofstream file(path, std::ios::binary);
+        IT_ASSERT(file.good(), "Cannot open " + path);
+        file.write(w.data().data(), w.size());
+        const char padding[blobAlignment] = {};
+        end = w.size();
+        for (size_t i = 0; i < patches.size(); ++i)
+        {
+            const auto &tensor = patches[i].second;
+            file.write(padding, blobOffsets[i] - end);
+            file.write(tensor->getRawDataPtr<char *>(), tensor->getBytes());
+            end = blobOffsets[i] + tensor->getBytes();
+        }
+        IT_ASSERT(file.good(), "Cannot write " + path);
+    }
+
+    Graph loadGraph(Runtime runtime, const string &path)
+    {
+        auto mapping = make_ref<MappedFile>(path);
+        Reader r(mapping->data(), mapping->size());
+        for (char c : magic)
+            IT_ASSERT(r.get<char>() == c, path + " is not a model file");
+        IT_ASSERT(r.get<uint32_t>() == version,
+                  "Unsupported model file version");
+        IT_ASSERT(r.get<uint32_t>() == byteOrderMark,
+                  path + " was saved on a host of another byte order");
+        auto numTensors = r.get<uint32_t>();
+        auto numOps = r.get<uint32_t>();
+
+        Graph g = make_ref<GraphObj>(runtime);
+        TensorVec tensors;
+        for (uint32_t i = 0; i < numTensors; ++i)
+        {
+            auto dtype = r.get<int32_t>();
+            IT_ASSERT(dtype > 0 && dtype < int(std::size(DataType::names)) &&
+                          DataType(dtype).getSize() > 0,
+                      "Bad data type in model file");
+            auto tensor = g->addTensor(r.getVector<int>(), DataType(dtype));
+            auto offset = r.get<uint64_t>();
+            auto bytes = r.get<uint64_t>();
+            if (bytes > 0)
+            {
+                IT_ASSERT(bytes == tensor->getBytes() &&
+                              offset % blobAlignment == 0 &&
+                              offset <= mapping->size() &&
+                              bytes <= mapping->size() - offset,
+                          "Bad weight blob in model file");
+                tensor->setDataBlob(make_ref<BlobObj>(
+                    runtime, mapping->data() + offset, mapping));
+                tensor->setConstant();
+            }
+            tensors.emplace_back(tensor);
+        }
+        auto tensorAt = [&](uint32_t i)
+        {
+            IT_ASSERT(i < tensors.size(), "Bad tensor index in model file");
+            return tensors[i];
+        };
+        for (uint32_t i = 0; i < numOps; ++i)
+        {
+            OpType type(r.get<uint16_t>());
+            TensorVec inputs;
+            for (auto idx : r.getVector<uint32_t>())
+                inputs.emplace_back(tensorAt(idx));
+            auto outputs = r.getVector<uint32_t>();
+            IT_ASSERT(outputs.size() == 1, "Bad operator outputs");
+            readOperator(r, g, type, inputs, tensorAt(outputs[0]));
+        }
+        return g;
+    }
+
+} // namespace infini
@@ -113,4 +113,16 @@ void TensorObj::setData(
 
 void TensorObj::setDataBlob(const Blob &blob) { this->data = blob; }
 
+void TensorObj::setConstant() {
+    constant = true;
+    if (data && data->isExternal())
+        return;
+    // Memory of its own, outside the arena dataMalloc plans, keeping what was
+    // already written to the tensor.
+    auto owner = std::make_shared<vector<uint64_t>>((getBytes() + 7) / 8);
+    if (data)
+        std::memcpy(owner->data(), data->getPtr<void *>(), getBytes());
+    data = make_ref<BlobObj>(runtime, owner->data(), owner);
+}
+
 }; // namespace infini
@@ -0,0 +1,131 @@
+#include "core/kernel.h"
+#include "operators/unary.h"
+#include "utils/half.h"
+#include <algorithm>
+#include <limits>
+#include <type_traits>
+
+namespace infini {
+
+class NativeCast : public CpuKernelWithoutConfig {
+    // Work is split into chunks so that threads get contiguous runs.
+    static constexpr size_t chunkSize = 16384;
+    // Below this many elements threading costs more than it saves.
+    static constexpr size_t parallelThreshold = 32768;
+
+    // Narrowing conversions saturate at the bounds of the destination type,
+    // and float nan becomes 0.
+    template <typename S, typename D> static D convert(S val) {
+        if constexpr (std::is_floating_point_v<D>) {
+            return D(val);
+        } else if constexpr (std::is_floating_point_v<S>) {
+            constexpr S lo = S(std::numeric_limits<D>::lowest());
+            constexpr S hi = S(std::numeric_limits<D>::max());
+            if (!(val == val))
+                return 0;
+            return val <= lo ? std::numeric_limits<D>::lowest()
+                   : val >= hi ? std::numeric_limits<D>::max()
+                               : D(val);
+        } else {
+            // every integer type a cast reads or writes fits in int64
+            constexpr int64_t lo = std::numeric_limits<D>::lowest();
+            constexpr int64_t hi = std::numeric_limits<D>::max();
+            int64_t v = int64_t(val);
+            return D(std::min(std::max(v, lo), hi));
+        }
+    }
+
+    template <typename S, typename D>
+    static void castRun(const S *src, D *dst, size_t n) {
+#pragma omp simd
+        for (size_t i = 0; i < n; ++i)
+            dst[i] = convert<S, D>(src[i]);
+    }
+
+    template <typename S, typename D>
+    static KernelFunc bind(const Operator &op,
+                           void (*run)(const S *, D *, size_t) = castRun<S, D>) {
+        IT_ASSERT(op->getInputs(0)->getDType().getSize() == sizeof(S));
+        IT_ASSERT(op->getOutput()->getDType().getSize() == sizeof(D));
+        auto src = op->getInputs(0)->getRawDataPtr<S *>();
+        auto dst = op->getOutput()->getRawDataPtr<D *>();
+        size_t n = op->getOutput()->size();
+        return [=]() {
+            size_t chunks = (n + chunkSize - 1) / chunkSize;
+#pragma omp parallel for if (n >= parallelThreshold)
+            for (size_t c = 0; c < chunks; ++c) {
+                size_t begin = c * chunkSize;
+                run(src + begin, dst + begin, std::min(chunkSize, n - begin));
+            }
+        };
+    }
+
+    KernelFunc prepare(const Operator &_op,
+                       const RuntimeObj *context) const override {
+        auto op = as<CastObj>(_op);
+        switch (op->getType()) {
+        // half and bfloat16 are stored as uint16_t
+        case CastType::Float2Float16:
+            return bind<float, uint16_t>(op, fp32ToFp16);
+        case CastType::Float2BFloat16:
+            return bind<float, uint16_t>(op, fp32ToBf16);
+        case CastType::Float162Float:
+            return bind<uint16_t, float>(op, fp16ToFp32);
+        case CastType::BFloat162Float:
+            return bind<uint16_t, float>(op, bf16ToFp32);
+        case CastType::Float2Int64:
+            return bind<float, int64_t>(op);
+        case CastType::Float2Int32:
+            return bind<float, int32_t>(op);
+        case CastType::Float2Int16:
+            return bind<float, int16_t>(op);
+        case CastType::Float2Int8:
+            return bind<float, int8_t>(op);
+        case CastType::Int322Float:
+            return bind<int32_t, float>(op);
+        case CastType::Int322Int8:
+            return bind<int32_t, int8_t>(op);
+        case CastType::Int322Int16:
+            return bind<int32_t, int16_t>(op);
+        case CastType::Int322Int64:
+            return bind<int32_t, int64_t>(op);
+        case CastType::Int162Float:
+            return bind<int16_t, float>(op);
+        case CastType::Int162Int32:
+            return bind<int16_t, int32_t>(op);
+        case CastType::Int82Float:
+            return bind<int8_t, float>(op);
+        case CastType::Int82Int16:
+            return bind<int8_t, int16_t>(op);
+        case CastType::Int82Int32:
+            return bind<int8_t, int32_t>(op);
+        case CastType::Uint82Float:
+            return bind<uint8_t, float>(op);
+        case CastType::Uint82Int32:
+            return bind<uint8_t, int32_t>(op);
+        case CastType::Uint82Int64:
+            return bind<uint8_t, int64_t>(op);
+        case CastType::Int642Int32:
+            return bind<int64_t, int32_t>(op);
+        case CastType::Int642Uint32:
+            return bind<int64_t, uint32_t>(op);
+        case CastType::Int642Float:
+            return bind<int64_t, float>(op);
+        case CastType::Uint322Int64:
+            return bind<uint32_t, int64_t>(op);
+        case CastType::Float2Float:
+            return bind<float, float>(op);
+        default:
+            IT_TODO_HALT();
+        }
+    }
+
+    void compute(const Operator &_op,
+                 const RuntimeObj *context) const override {
+        prepare(_op, context)();
+    }
+};
+
+REGISTER_KERNEL(Device::CPU, OpType::Cast, NativeCast, "Cast_CPU");
+
+} // namespace infini
@@ -1,64 +1,124 @@
 #include "operators/concat.h"
 #include "core/kernel.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define CONCAT_X86 1
+#endif
 
 namespace infini {
 
-class NaiveConcat : public CpuKernelWithoutConfig {
-    template <typename T>
-    void doCompute(const Operator &_op, const RuntimeObj *context) const {
+// Copy with non-temporal stores, for outputs too large to stay in cache
+// until they are read: streaming skips the read-for-ownership of every
+// destination line and leaves the cache to the data still in use.
+static void streamCopy(char *dst, const char *src, size_t bytes) {
+#ifdef CONCAT_X86
+    size_t head = (16 - reinterpret_cast<uintptr_t>(dst) % 16) % 16;
+    if (head >= bytes) {
+        std::memcpy(dst, src, bytes);
+        return;
+    }
+    std::memcpy(dst, src, head);
+    size_t i = head;
+    for (; i + 16 <= bytes; i += 16)
+        _mm_stream_si128(
+            reinterpret_cast<__m128i *>(dst + i),
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i)));
+    std::memcpy(dst + i, src + i, bytes - i);
+#else
+    std::memcpy(dst, src, bytes);
+#endif
+}
+
+class BlockConcat : public CpuKernelWithoutConfig {
+    // Each input contributes `outer` contiguous blocks of `blockBytes` to
+    // the output, every output block holding one block of each input.
+    // Blocks are cut into chunks so that a few large blocks still spread
+    // over all threads.
+    struct Piece {
+        const char *src;
+        size_t blockBytes, dstOffset;
+        size_t firstChunk; // chunks of the preceding pieces, per block
+    };
+
+    static constexpr size_t chunkBytes = 64 << 10;
+    // Below this many bytes threading costs more than it saves.
+    static constexpr size_t parallelThreshold = 128 << 10;
+    // Outputs beyond this size are unlikely to still be cached when read.
+    static constexpr size_t streamThreshold = 8 << 20;
+
+    KernelFunc prepare(const Operator &_op,
+                       const RuntimeObj *context) const override {
         auto op = as<ConcatObj>(_op);
-        auto inputs = op->getInputs(), outputs = op->getOutputs();
+        auto output = op->getOutput();
         auto dim = op->getDim();
-        auto output = outputs[0];
-        std::vector<Shape> iDims;
-        for (auto input : inputs)
-            iDims.emplace_back(input->getDims());
         const auto &outDim = output->getDims();
-        size_t blockOffsetInner = 1;
-        for (size_t i = outDim.size() - 1; i > (size_t)dim; --i)
-            blockOffsetInner *= outDim[i];
-        size_t blockOffset = outDim[dim] * blockOffsetInner;
-        for (size_t i = 0; i < inputs.size(); ++i) {
-            auto input = inputs[i];
-            auto dimOffset = 0;
-            auto iDim = iDims[i];
-            for (size_t j = 0; j < i; ++j)
-                dimOffset += iDims[j][dim];
-            size_t localBlockOffset = 1;
-            for (size_t i = iDim.size() - 1;
-                 i >= (size_t)dim && i != (size_t)-1; --i)
-                localBlockOffset *= iDim[i];
-            auto innerOffset = blockOffsetInner * dimOffset;
-            auto inSize = input->size();
-            auto inPtr = input->getRawDataPtr<T *>(),
-                 outPtr = output->getRawDataPtr<T *>();
-#pragma omp parallel for
-            for (size_t iOffset = 0; iOffset < inSize; ++iOffset) {
-                auto oOffset = iOffset % localBlockOffset + innerOffset +
-                               iOffset / localBlockOffset * blockOffset;
-                outPtr[oOffset] = inPtr[iOffset];
+        size_t elemSize = output->getDType().getSize();
+        size_t outer = 1, inner = elemSize;
+        for (int i = 0; i < dim; ++i)
+            outer *= outDim[i];
+        for (size_t i = dim + 1; i < outDim.size(); ++i)
+            inner *= outDim[i];
+        size_t outBlockBytes = outDim[dim] * inner;
+        auto dst = output->getRawDataPtr<char *>();
+
+        vector<Piece> pieces;
+        size_t chunks = 0, dstOffset = 0;
+        for (auto &input : op->getInputs()) {
+            size_t blockBytes = input->getDims()[dim] * inner;
+            auto src = input->getRawDataPtr<char *>();
+            // The memory planner may have placed the input at its slice of
+            // the output already, so there is nothing to copy.
+            if (blockBytes != 0 && !(outer == 1 && src == dst + dstOffset)) {
+                pieces.push_back({src, blockBytes, dstOffset, chunks});
+                chunks += (blockBytes + chunkBytes - 1) / chunkBytes;
             }
+            dstOffset += blockBytes;
         }
+        size_t tasks = outer * chunks;
+        size_t bytes = output->getBytes();
+        bool parallel = bytes >= parallelThreshold;
+        bool stream = bytes >= streamThreshold;
+        return [=]() {
+#pragma omp parallel if (parallel)
+            {
+#pragma omp for
+                for (size_t task = 0; task < tasks; ++task) {
+                    size_t o = task / chunks, c = task % chunks;
+                    auto piece = std::upper_bound(pieces.begin(), pieces.end(),
+                                                  c,
+                                                  [](size_t c, const Piece &p) {
+                                                      return c < p.firstChunk;
+                                                  }) -
+                                 1;
+                    size_t begin = (c - piece->firstChunk) * chunkBytes;
+                    size_t len =
+                        std::min(chunkBytes, piece->blockBytes - begin);
+                    auto to = dst + o * outBlockBytes + piece->dstOffset + begin;
+                    auto from = piece->src + o * piece->blockBytes + begin;
+                    if (stream)
+                        streamCopy(to, from, len);
+                    else
+                        std::memcpy(to, from, len);
+                }
+#ifdef CONCAT_X86
+                // Make this thread's streaming stores visible to the readers
+                if (stream)
+                    _mm_sfence();
+#endif
+            }
+        };
     }
 
     void compute(const Operator &_op,
                  const RuntimeObj *context) const override {
-#define CASE(N)                                                                \
-    case N:                                                                    \
-        doCompute<DT<N>::t>(_op, context)
-
-        int dataTypeIdx = _op->getDType().getIndex();
-        switch (dataTypeIdx) {
-            CASE(1); // DataType::Float32
-            break;
-            CASE(12); // DataType::UInt32
-            break;
-        default:
-            IT_TODO_HALT();
-        }
+        prepare(_op, context)();
     }
 };
 
-REGISTER_KERNEL(Device::CPU, OpType::Concat, NaiveConcat, "ConcatNaive_CPU");
+REGISTER_KERNEL(Device::CPU, OpType::Concat, BlockConcat, "ConcatBlock_CPU");
 
 } // namespace infini
@@ -1,114 +1,226 @@
 #include "operators/element_wise.h"
 #include "core/kernel.h"
+#include "utils/half.h"
 #include "utils/operator_utils.h"
 
 namespace infini
 {
     class NativeElementWise : public CpuKernelWithoutConfig
     {
-        template <typename T>
-        static T addCompute(T val0, T val1)
+        struct AddOp
         {
-            return val0 + val1;
-        }
+            template <typename T>
+            T operator()(T val0, T val1) const { return val0 + val1; }
+        };
 
-        template <typename T>
-        static T subCompute(T val0, T val1)
+        struct SubOp
         {
-            return val0 - val1;
-        }
+            template <typename T>
+            T operator()(T val0, T val1) const { return val0 - val1; }
+        };
+
+        struct MulOp
+        {
+            template <typename T>
+            T operator()(T val0, T val1) const { return val0 * val1; }
+        };
+
+        struct DivOp
+        {
+            template <typename T>
+            T operator()(T val0, T val1) const { return (T)(val0 / val1); }
+        };
+
+        // Work is split into chunks of the innermost dim so that a single
+        // large row still spreads over all threads.
+        static constexpr size_t chunkSize = 16384;
+        // Below this many elements threading costs more than it saves.
+        static constexpr size_t parallelThreshold = 32768;
 
+        // Inner loops over the innermost dim, where each input is either
+        // contiguous or a single broadcast value.
         template <typename T>
-        static T mulCompute(T val0, T val1)
+        struct Direct
+        {
+            template <typename Op>
+            static void vv(const T *a, const T *b, T *c, size_t n)
+            {
+#pragma omp simd
+                for (size_t i = 0; i < n; ++i)
+                    c[i] = Op()(a[i], b[i]);
+            }
+
+            template <typename Op>
+            static void vs(const T *a, const T *b, T *c, size_t n)
+            {
+                const T val1 = *b;
+#pragma omp simd
+                for (size_t i = 0; i < n; ++i)
+                    c[i] = Op()(a[i], val1);
+            }
+
+            template <typename Op>
+            static void sv(const T *a, const T *b, T *c, size_t n)
+            {
+                const T val0 = *a;
+#pragma omp simd
+                for (size_t i = 0; i < n; ++i)
+                    c[i] = Op()(val0, b[i]);
+            }
+        };
+
+        // The same loops for half and bfloat16 storage: blocks are loaded into
+        // fp32, computed there and rounded on store.
+        template <typename Storage>
+        struct Reduced
+        {
+            static constexpr size_t block = 256;
+
+            template <typename Op>
+            static void vv(const uint16_t *a, const uint16_t *b, uint16_t *c,
+                           size_t n)
+            {
+                float fa[block], fb[block];
+                for (size_t i = 0; i < n; i += block)
+                {
+                    size_t len = std::min(block, n - i);
+                    Storage::load(a + i, fa, len);
+                    Storage::load(b + i, fb, len);
+                    Direct<float>::vv<Op>(fa, fb, fa, len);
+                    Storage::store(fa, c + i, len);
+                }
+            }
+
+            template <typename Op>
+            static void vs(const uint16_t *a, const uint16_t *b, uint16_t *c,
+                           size_t n)
+            {
+                float fa[block], val1 = Storage::load(*b);
+                for (size_t i = 0; i < n; i += block)
+                {
+                    size_t len = std::min(block, n - i);
+                    Storage::load(a + i, fa, len);
+                    Direct<float>::vs<Op>(fa, &val1, fa, len);
+                    Storage::store(fa, c + i, len);
+                }
+            }
+
+            template <typename Op>
+            static void sv(const uint16_t *a, const uint16_t *b, uint16_t *c,
+                           size_t n)
+            {
+                float val0 = Storage::load(*a), fb[block];
+                for (size_t i = 0; i < n; i += block)
+                {
+                    size_t len = std::min(block, n - i);
+                    Storage::load(b + i, fb, len);
+                    Direct<float>::sv<Op>(&val0, fb, fb, len);
+                    Storage::store(fb, c + i, len);
+                }
+            }
+        };
+
+        template <typename T, typename Rows, typename Op>
+        static void broadcastCompute(const T *inptr0, const T *inptr1, T *outptr,
+                                     const BroadcastLayout &layout)
         {
-            return val0 * val1;
+            const auto &dims = layout.dims;
+            const auto &strideA = layout.strides[0], &strideB = layout.strides[1];
+            size_t rank = dims.size(), inner = dims.back();
+            size_t rows = 1;
+            for (size_t i = 0; i + 1 < rank; ++i)
+                rows *= dims[i];
+            void (*row)(const T *, const T *, T *, size_t) =
+                strideA.back() == 0   ? Rows::template sv<Op>
+                : strideB.back() == 0 ? Rows::template vs<Op>
+                                      : Rows::template vv<Op>;
+
+            size_t chunk = std::min(inner, chunkSize);
+            size_t chunksPerRow = (inner + chunk - 1) / chunk;
+            size_t tasks = rows * chunksPerRow;
+#pragma omp parallel for if (rows * inner >= parallelThreshold)
+            for (size_t task = 0; task < tasks; ++task)
+            {
+                size_t r = task / chunksPerRow;
+                size_t begin = task % chunksPerRow * chunk;
+                size_t indexA = begin * strideA.back();
+                size_t indexB = begin * strideB.back();
+                // One div/mod per outer dim per chunk, not per element.
+                for (size_t i = rank - 1; i > 0; --i)
+                {
+                    size_t idx = r % dims[i - 1];
+                    r /= dims[i - 1];
+                    indexA += idx * strideA[i - 1];
+                    indexB += idx * strideB[i - 1];
+                }
+                size_t offset = task / chunksPerRow * inner + begin;
+                row(inptr0 + indexA, inptr1 + indexB, outptr + offset,
+                    std::min(chunk, inner - begin));
+            }
         }
 
-        template <typename T>
-        static T divCompute(T val0, T val1)
+        template <typename T, typename Rows, typename Op>
+        static KernelFunc bind(const T *inptr0, const T *inptr1, T *outptr,
+                               BroadcastLayout layout)
         {
-            return (T)(val0 / val1);
+            return [=, layout = std::move(layout)]()
+            { broadcastCompute<T, Rows, Op>(inptr0, inptr1, outptr, layout); };
         }
 
-        template <typename T>
-        void doCompute(const Operator &_op, const RuntimeObj *context) const
+        template <typename T, typename Rows>
+        KernelFunc doPrepare(const Operator &_op,
+                             const RuntimeObj *context) const
         {
             auto op = as<ElementWiseObj>(_op);
             T *inptr0 = op->getInputs(0)->getRawDataPtr<T *>();
             T *inptr1 = op->getInputs(1)->getRawDataPtr<T *>();
             T *outptr = op->getOutput()->getRawDataPtr<T *>();
 
-            auto shapeA = op->getInputs(0)->getDims();
-            auto shapeB = op->getInputs(1)->getDims();
-            auto shapeC = op->getOutput()->getDims();
-            auto rank = op->getOutput()->getRank();
-            Shape a(rank, 1);
-            Shape b(rank, 1);
-            std::copy(shapeA.begin(), shapeA.end(),
-                      a.begin() + (rank - shapeA.size()));
-            std::copy(shapeB.begin(), shapeB.end(),
-                      b.begin() + (rank - shapeB.size()));
-            auto getStride = [&](const Shape &shape)
-            {
-                int p = 1;
-                Shape stride(rank);
-                for (auto i = rank; i > 0; --i)
-                {
-                    stride[i - 1] = p;
-                    p = p * shape[i - 1];
-                }
-                return stride;
-            };
-            Shape strideA = getStride(a);
-            Shape strideB = getStride(b);
-
-            auto n = op->getOutput()->size();
-            T (*_doCompute)
-            (T val0, T val1);
+            auto layout = collapse_broadcast({op->getInputs(0)->getDims(),
+                                              op->getInputs(1)->getDims()},
+                                             op->getOutput()->getDims());
             switch (op->getOpType().underlying())
             {
             case OpType::Add:
-                _doCompute = addCompute<T>;
-                break;
+                return bind<T, Rows, AddOp>(inptr0, inptr1, outptr, layout);
             case OpType::Sub:
-                _doCompute = subCompute<T>;
-                break;
+                return bind<T, Rows, SubOp>(inptr0, inptr1, outptr, layout);
             case OpType::Mul:
-                _doCompute = mulCompute<T>;
-                break;
+                return bind<T, Rows, MulOp>(inptr0, inptr1, outptr, layout);
             case OpType::Div:
-                _doCompute = divCompute<T>;
-                break;
+                return bind<T, Rows, DivOp>(inptr0, inptr1, outptr, layout);
             default:
                 IT_TODO_HALT();
             }
-
-            for (size_t i = 0; i < n; ++i)
-            {
-                auto shapeIndexC = locate_index(i, shapeC);
-                auto indexA = delocate_index(shapeIndexC, a, strideA);
-                auto indexB = delocate_index(shapeIndexC, b, strideB);
-                outptr[i] = _doCompute(inptr0[indexA], inptr1[indexB]);
-            }
         }
 
-        void compute(const Operator &_op,
-                     const RuntimeObj *context) const override
+        KernelFunc prepare(const Operator &_op,
+                           const RuntimeObj *context) const override
         {
 #define CASE(N) \
     case N:     \
-        doCompute<DT<N>::t>(_op, context)
+        return doPrepare<DT<N>::t, Direct<DT<N>::t>>(_op, context)
 
             int dataTypeIdx = _op->getDType().getIndex();
             switch (dataTypeIdx)
             {
                 CASE(1); // DataType::Float32
-                break;
                 CASE(12); // DataType::UInt32
-                break;
+            case 10: // DataType::Float16
+                return doPrepare<uint16_t, Reduced<Float16Storage>>(_op, context);
+            case 16: // DataType::BFloat16
+                return doPrepare<uint16_t, Reduced<BFloat16Storage>>(_op,
+                                                                     context);
             default:
                 IT_TODO_HALT();
             }
+#undef CASE
+        }
+
+        void compute(const Operator &_op,
+                     const RuntimeObj *context) const override
+        {
+            prepare(_op, context)();
         }
     };
 
@@ -0,0 +1,262 @@
+#include "operators/fused_element_wise.h"
+#include "core/kernel.h"
+#include "utils/half.h"
+#include "utils/operator_utils.h"
+#include <limits>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace infini
+{
+    class NativeFusedElementWise : public CpuKernelWithoutConfig
+    {
+        using Step = FusedElementWiseObj::Step;
+
+        // The chain runs over blocks of this many output elements, so the
+        // intermediates of a block stay in L1 from one step to the next and
+        // never reach memory.
+        static constexpr size_t blockSize = 512;
+        // Below this many elements threading costs more than it saves.
+        static constexpr size_t parallelThreshold = 32768;
+
+        static int maxThreads()
+        {
+#ifdef _OPENMP
+            return omp_get_max_threads();
+#else
+            return 1;
+#endif
+        }
+
+        static int threadNum()
+        {
+#ifdef _OPENMP
+            return omp_get_thread_num();
+#else
+            return 0;
+#endif
+        }
+
+        // The type the chain computes in: T itself, or fp32 for half and
+        // bfloat16 storage.
+        template <typename T, typename Storage>
+        using ComputeType =
+            std::conditional_t<std::is_void_v<Storage>, T, float>;
+
+        // Per-thread working memory of a prepared launch, allocated once so
+        // that runs of the launch do not allocate: one block per step
+        // result, plus one per input to hold a broadcast value spread over
+        // the block or the converted input, and the operand pointers.
+        template <typename C>
+        struct Scratch
+        {
+            int threads;
+            size_t chunk;
+            vector<C> blocks;
+            vector<const C *> operands;
+        };
+
+        template <typename T>
+        static T bound(float val)
+        {
+            constexpr T lo = std::numeric_limits<T>::lowest();
+            constexpr T hi = std::numeric_limits<T>::max();
+            return val <= (float)lo ? lo : val >= (float)hi ? hi : (T)val;
+        }
+
+        template <typename T>
+        static void applyStep(const Step &step, const T *a, const T *b, T *c,
+                              size_t n)
+        {
+            switch (step.type.underlying())
+            {
+            case OpType::Add:
+#pragma omp simd
+                for (size_t i = 0; i < n; ++i)
+                    c[i] = a[i] + b[i];
+                break;
+            case OpType::Sub:
+#pragma omp simd
+                for (size_t i = 0; i < n; ++i)
+                    c[i] = a[i] - b[i];
+                break;
+            case OpType::Mul:
+#pragma omp simd
+                for (size_t i = 0; i < n; ++i)
+                    c[i] = a[i] * b[i];
+                break;
+            case OpType::Div:
+#pragma omp simd
+                for (size_t i = 0; i < n; ++i)
+                    c[i] = (T)(a[i] / b[i]);
+                break;
+            case OpType::Relu:
+#pragma omp simd
+                for (size_t i = 0; i < n; ++i)
+                    c[i] = std::max(T(0), a[i]);
+                break;
+            case OpType::Clip:
+            {
+                T lo = step.min ? bound<T>(*step.min)
+                                : std::numeric_limits<T>::lowest();
+                T hi = step.max ? bound<T>(*step.max)
+                                : std::numeric_limits<T>::max();
+#pragma omp simd
+                for (size_t i = 0; i < n; ++i)
+                    c[i] = a[i] < lo ? lo : a[i] > hi ? hi : a[i];
+                break;
+            }
+            default:
+                IT_TODO_HALT();
+            }
+        }
+
+        // Storage is void when T is computed on directly, or the format of
+        // half and bfloat16 inputs, which are computed in fp32 blocks.
+        template <typename T, typename Storage>
+        static void fusedCompute(const vector<const T *> &inputs, T *outptr,
+                                 const vector<Step> &steps,
+                                 const BroadcastLayout &layout,
+                                 Scratch<ComputeType<T, Storage>> &work)
+        {
+            const auto &dims = layout.dims;
+            size_t rank = dims.size(), inner = dims.back();
+            size_t rows = 1;
+            for (size_t i = 0; i + 1 < rank; ++i)
+                rows *= dims[i];
+            size_t numInputs = inputs.size(), numSteps = steps.size();
+            constexpr bool direct = std::is_void_v<Storage>;
+            using C = ComputeType<T, Storage>;
+
+            size_t chunk = work.chunk;
+            size_t chunksPerRow = (inner + chunk - 1) / chunk;
+            size_t tasks = rows * chunksPerRow;
+            int threads = std::min(work.threads, maxThreads());
+#pragma omp parallel num_threads(threads) \
+    if (rows * inner >= parallelThreshold)
+            {
+                int thread = threadNum();
+                C *scratch = work.blocks.data() +
+                             thread * (numSteps + numInputs) * chunk;
+                const C **operands = work.operands.data() + thread * numInputs;
+#pragma omp for
+                for (size_t task = 0; task < tasks; ++task)
+                {
+                    size_t begin = task % chunksPerRow * chunk;
+                    size_t len = std::min(chunk, inner - begin);
+                    for (size_t j = 0; j < numInputs; ++j)
+                    {
+                        const auto &strides = layout.strides[j];
+                        size_t r = task / chunksPerRow;
+                        size_t index = begin * strides.back();
+                        for (size_t i = rank - 1; i > 0; --i)
+                        {
+                            index += r % dims[i - 1] * strides[i - 1];
+                            r /= dims[i - 1];
+                        }
+                        C *row = scratch + (numSteps + j) * chunk;
+                        if (strides.back() == 0)
+                        {
+                            if constexpr (direct)
+                                std::fill(row, row + len, inputs[j][index]);
+                            else
+                                std::fill(row, row + len,
+                                          Storage::load(inputs[j][index]));
+                            operands[j] = row;
+                        }
+                        else if constexpr (direct)
+                            operands[j] = inputs[j] + index;
+                        else
+                        {
+                            Storage::load(inputs[j] + index, row, len);
+                            operands[j] = row;
+                        }
+                    }
+                    auto operand = [&](int id) -> const C *
+                    {
+                        if (id >= 0)
+                            return operands[id];
+                        return scratch +
+                               FusedElementWiseObj::operandStep(id) * chunk;
+                    };
+                    size_t offset = task / chunksPerRow * inner + begin;
+                    for (size_t k = 0; k < numSteps; ++k)
+                    {
+                        const auto &step = steps[k];
+                        C *result = scratch + k * chunk;
+                        if constexpr (direct)
+                            if (k + 1 == numSteps)
+                                result = outptr + offset;
+                        bool unary = step.type == OpType::Relu ||
+                                     step.type == OpType::Clip;
+                        applyStep(step, operand(step.lhs),
+                                  unary ? nullptr : operand(step.rhs), result,
+                                  len);
+                    }
+                    if constexpr (!direct)
+                        Storage::store(scratch + (numSteps - 1) * chunk,
+                                       outptr + offset, len);
+                }
+            }
+        }
+
+        template <typename T, typename Storage = void>
+        KernelFunc doPrepare(const Operator &_op,
+                             const RuntimeObj *context) const
+        {
+            auto op = as<FusedElementWiseObj>(_op);
+            vector<const T *> inptrs;
+            vector<Shape> shapes;
+            for (const auto &input : op->getInputs())
+            {
+                inptrs.emplace_back(input->getRawDataPtr<T *>());
+                shapes.emplace_back(input->getDims());
+            }
+            T *outptr = op->getOutput()->getRawDataPtr<T *>();
+            auto layout = collapse_broadcast(shapes, op->getOutput()->getDims());
+            const auto &steps = op->getSteps();
+            size_t width = steps.size() + inptrs.size();
+            auto work = std::make_shared<Scratch<ComputeType<T, Storage>>>();
+            work->threads = maxThreads();
+            work->chunk = std::min(layout.dims.back(), blockSize);
+            work->blocks.resize(work->threads * width * work->chunk);
+            work->operands.resize(work->threads * inptrs.size());
+            return [=]()
+            {
+                fusedCompute<T, Storage>(inptrs, outptr, steps, layout, *work);
+            };
+        }
+
+        KernelFunc prepare(const Operator &_op,
+                           const RuntimeObj *context) const override
+        {
+#define CASE(N) \
+    case N:     \
+        return doPrepare<DT<N>::t>(_op, context)
+
+            int dataTypeIdx = _op->getDType().getIndex();
+            switch (dataTypeIdx)
+            {
+                CASE(1); // DataType::Float32
+                CASE(12); // DataType::UInt32
+            case 10: // DataType::Float16
+                return doPrepare<uint16_t, Float16Storage>(_op, context);
+            case 16: // DataType::BFloat16
+                return doPrepare<uint16_t, BFloat16Storage>(_op, context);
+            default:
+                IT_TODO_HALT();
+            }
+#undef CASE
+        }
+
+        void compute(const Operator &_op,
+                     const RuntimeObj *context) const override
+        {
+            prepare(_op, context)();
+        }
+    };
+
+    REGISTER_KERNEL(Device::CPU, OpType::FusedElementWise,
+                    NativeFusedElementWise, "FusedElementWise_CPU");
+}; // namespace infini
@@ -0,0 +1,287 @@
+#include "operators/matmul.h"
+#include "core/kernel.h"
+#include "utils/gemm.h"
+#include "utils/half.h"
+#include <array>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <type_traits>
+
+namespace infini {
+
+class BlockedMatmul : public CpuKernelWithoutConfig {
+    // Matrix strides of each leading (batch) dimension of `shape` after it is
+    // right-aligned to `rank` dimensions. Broadcast dimensions get stride 0.
+    static vector<size_t> getBatchStrides(const Shape &shape, size_t rank) {
+        vector<size_t> stride(rank, 0);
+        size_t batchRank = shape.size() - 2, p = 1;
+        for (size_t i = 0; i < batchRank; ++i) {
+            auto dim = shape[batchRank - 1 - i];
+            stride[rank - 1 - i] = dim == 1 ? 0 : p;
+            p *= dim;
+        }
+        return stride;
+    }
+
+    // Finish a row of a quantized matmul from its int32 accumulators: remove
+    // the zero point of A, dequantize, add the bias, clamp and store either
+    // the float or the value requantized to Out.
+    template <typename Out>
+    static void finishQuantizedRow(const int32_t *acc, const int32_t *colSum,
+                                   const float *colScale, const float *bias,
+                                   size_t biasColStride,
+                                   const MatmulQuantization &q, float lo,
+                                   float hi, Out *out, int n) {
+        constexpr float qlo = std::numeric_limits<Out>::lowest();
+        constexpr float qhi = std::numeric_limits<Out>::max();
+        float invScale = 1.f / q.scaleC;
+        for (int j = 0; j < n; ++j) {
+            float v = colScale[j] * float(acc[j] - q.zeroA * colSum[j]);
+            if (bias)
+                v += bias[j * biasColStride];
+            v = std::min(std::max(v, lo), hi);
+            if constexpr (std::is_floating_point_v<Out>)
+                out[j] = v;
+            else
+                out[j] = Out(std::min(
+                    std::max(std::nearbyint(v * invScale) + q.zeroC, qlo),
+                    qhi));
+        }
+    }
+
+    // Pack every matrix of a constant B, such as a weight, once here, so
+    // that runs of the prepared launch only pack A. Only worth it for a
+    // launch that is kept: a single compute packs B panel by panel instead.
+    template <typename T>
+    static std::shared_ptr<vector<GemmPackedB>>
+    packConstantB(bool prepack, const Tensor &B, bool transB, int k, int n,
+                  size_t ldb, size_t matB,
+                  GemmPackedB (*pack)(bool, int, int, const T *, size_t)) {
+        if (!prepack || !B->isConstant() || matB == 0)
+            return nullptr;
+        auto ptr = B->getRawDataPtr<T *>();
+        auto packed = std::make_shared<vector<GemmPackedB>>();
+        for (size_t offset = 0; offset < B->size(); offset += matB)
+            packed->emplace_back(pack(transB, k, n, ptr + offset, ldb));
+        return packed;
+    }
+
+    KernelFunc doPrepare(const Operator &_op, bool prepackB) const {
+        auto op = as<MatmulObj>(_op);
+        auto dtype = op->getDType();
+        IT_ASSERT(dtype == DataType::Float32 || dtype == DataType::Float16 ||
+                  dtype == DataType::BFloat16 || op->getQuantization());
+        auto A = op->getInputs(0), B = op->getInputs(1), C = op->getOutput();
+        const auto &shapeA = A->getDims(), &shapeB = B->getDims(),
+                   &shapeC = C->getDims();
+        bool transA = op->getTransA(), transB = op->getTransB();
+        int m = shapeC[shapeC.size() - 2], n = shapeC[shapeC.size() - 1];
+        int k = transA ? shapeA[shapeA.size() - 2] : shapeA[shapeA.size() - 1];
+        size_t lda = shapeA.back(), ldb = shapeB.back(), ldc = n;
+        size_t matA = (size_t)m * k, matB = (size_t)k * n, matC = (size_t)m * n;
+
+        size_t batchRank = shapeC.size() - 2;
+        auto strideA = getBatchStrides(shapeA, batchRank);
+        auto strideB = getBatchStrides(shapeB, batchRank);
+        size_t batch = C->size() / matC;
+
+        // The bias is broadcast to C, so it gets per-dim element strides over
+        // the whole of C, 0 along broadcast dims.
+        auto bias = op->getBias();
+        vector<size_t> strideBias(shapeC.size(), 0);
+        if (bias) {
+            const auto &shapeBias = bias->getDims();
+            size_t offset = shapeC.size() - shapeBias.size(), p = 1;
+            for (size_t i = shapeBias.size(); i > 0; --i) {
+                auto dim = shapeBias[i - 1];
+                strideBias[offset + i - 1] = dim == 1 ? 0 : p;
+                p *= dim;
+            }
+        }
+
+        // Element offsets of A, B and the bias for every output batch.
+        vector<std::array<size_t, 3>> offsets(batch);
+        for (size_t b = 0; b < batch; ++b) {
+            size_t offsetA = 0, offsetB = 0, offsetBias = 0;
+            for (size_t i = batchRank, rest = b; i > 0; --i) {
+                size_t idx = rest % shapeC[i - 1];
+                rest /= shapeC[i - 1];
+                offsetA += idx * strideA[i - 1];
+                offsetB += idx * strideB[i - 1];
+                offsetBias += idx * strideBias[i - 1];
+            }
+            offsets[b] = {offsetA * matA, offsetB * matB, offsetBias};
+        }
+
+        if (const auto &quant = op->getQuantization()) {
+            // igemm accumulates each matrix of C in int32; the zero point of
+            // A is then removed with the column sums of B, as
+            // sum((a - zeroA) * b) = sum(a * b) - zeroA * sum(b).
+            auto ptrA = A->getRawDataPtr<uint8_t *>();
+            auto ptrB = B->getRawDataPtr<int8_t *>();
+            auto ptrC = C->getRawDataPtr<char *>();
+            auto ptrBias = bias ? bias->getRawDataPtr<float *>() : nullptr;
+            size_t biasRowStride = strideBias[batchRank];
+            size_t biasColStride = strideBias[batchRank + 1];
+            float lo = op->getMin().value_or(-INFINITY);
+            float hi = op->getMax().value_or(INFINITY);
+            auto outType = C->getDType();
+            size_t outSize = outType.getSize();
+            auto q = *quant;
+            vector<float> colScale(n);
+            for (int j = 0; j < n; ++j)
+                colScale[j] = q.scaleA * q.scaleB[q.scaleB.size() == 1 ? 0 : j];
+            // Column sums of every matrix of B, computed here once when B is
+            // constant and otherwise at the start of each run; they are only
+            // needed when A has a zero point.
+            size_t countB = matB ? B->size() / matB : 1;
+            auto colSums = std::make_shared<vector<int32_t>>(countB * n);
+            auto sumColumns = [=]() {
+                for (size_t mat = 0; mat < countB; ++mat) {
+                    const int8_t *pb = ptrB + mat * matB;
+                    int32_t *sum = colSums->data() + mat * n;
+                    std::fill(sum, sum + n, 0);
+                    for (int p = 0; p < k; ++p)
+                        for (int j = 0; j < n; ++j)
+                            sum[j] += transB ? pb[j * ldb + p]
+                                             : pb[p * ldb + j];
+                }
+            };
+            bool constantB = B->isConstant();
+            if (q.zeroA != 0 && constantB)
+                sumColumns();
+            auto acc = std::make_shared<vector<int32_t>>(matC);
+            return [=]() {
+                if (q.zeroA != 0 && !constantB)
+                    sumColumns();
+                for (size_t b = 0; b < batch; ++b) {
+                    const int32_t *colSum =
+                        colSums->data() + (matB ? offsets[b][1] / matB : 0) * n;
+                    igemm(transA, transB, m, n, k, ptrA + offsets[b][0], lda,
+                          ptrB + offsets[b][1], ldb, acc->data(), ldc);
+#pragma omp parallel for
+                    for (int i = 0; i < m; ++i) {
+                        const float *biasRow =
+                            ptrBias ? ptrBias + offsets[b][2] +
+                                          i * biasRowStride
+                                    : nullptr;
+                        const int32_t *row = acc->data() + (size_t)i * n;
+                        char *out = ptrC + (b * matC + (size_t)i * n) * outSize;
+                        if (outType == DataType::UInt8)
+                            finishQuantizedRow(row, colSum, colScale.data(),
+                                               biasRow, biasColStride, q, lo,
+                                               hi, (uint8_t *)out, n);
+                        else if (outType == DataType::Int8)
+                            finishQuantizedRow(row, colSum, colScale.data(),
+                                               biasRow, biasColStride, q, lo,
+                                               hi, (int8_t *)out, n);
+                        else
+                            finishQuantizedRow(row, colSum, colScale.data(),
+                                               biasRow, biasColStride, q, lo,
+                                               hi, (float *)out, n);
+                    }
+                }
+            };
+        }
+
+        GemmEpilogue epilogue;
+        if (bias) {
+            if (dtype == DataType::Float32)
+                epilogue.bias = bias->getRawDataPtr<float *>();
+            epilogue.biasRowStride = strideBias[batchRank];
+            epilogue.biasColStride = strideBias[batchRank + 1];
+        }
+        if (auto min = op->getMin())
+            epilogue.lo = *min;
+        if (auto max = op->getMax())
+            epilogue.hi = *max;
+        bool hasEpilogue = bias || op->getMin() || op->getMax();
+
+        if (dtype == DataType::Float32) {
+            auto ptrA = A->getRawDataPtr<float *>();
+            auto ptrB = B->getRawDataPtr<float *>();
+            auto ptrC = C->getRawDataPtr<float *>();
+            auto packedB =
+                packConstantB(prepackB, B, transB, k, n, ldb, matB, sgemmPackB);
+            return [=]() {
+                for (size_t b = 0; b < batch; ++b) {
+                    GemmEpilogue ep = epilogue;
+                    if (ep.bias)
+                        ep.bias += offsets[b][2];
+                    if (packedB)
+                        sgemmPacked(transA, m, ptrA + offsets[b][0], lda,
+                                    (*packedB)[offsets[b][1] / matB],
+                                    ptrC + b * matC, ldc,
+                                    hasEpilogue ? &ep : nullptr);
+                    else
+                        sgemm(transA, transB, m, n, k, ptrA + offsets[b][0],
+                              lda, ptrB + offsets[b][1], ldb, ptrC + b * matC,
+                              ldc, hasEpilogue ? &ep : nullptr);
+                }
+            };
+        }
+
+        // Half and bfloat16: A and B are widened as gemm packs them, and each
+        // matrix of C is accumulated and finished in fp32, then rounded once.
+        bool half = dtype == DataType::Float16;
+        auto gemm = half ? hgemm : bf16gemm;
+        auto gemmPacked = half ? hgemmPacked : bf16gemmPacked;
+        auto ptrA = A->getRawDataPtr<uint16_t *>();
+        auto ptrB = B->getRawDataPtr<uint16_t *>();
+        auto ptrC = C->getRawDataPtr<uint16_t *>();
+        auto packedB = packConstantB(prepackB, B, transB, k, n, ldb, matB,
+                                     half ? hgemmPackB : bf16gemmPackB);
+        auto ptrBias = bias ? bias->getRawDataPtr<uint16_t *>() : nullptr;
+        size_t biasSize = bias ? bias->size() : 0;
+        // The bias is widened to fp32 here once when it is constant, and
+        // otherwise into the same buffer at the start of each run.
+        auto biasFp32 = std::make_shared<vector<float>>(biasSize);
+        auto widenBias = [=]() {
+            if (half)
+                fp16ToFp32(ptrBias, biasFp32->data(), biasSize);
+            else
+                bf16ToFp32(ptrBias, biasFp32->data(), biasSize);
+        };
+        bool constantBias = bias && bias->isConstant();
+        if (constantBias)
+            widenBias();
+        auto acc = std::make_shared<vector<float>>(matC);
+        return [=]() {
+            if (ptrBias && !constantBias)
+                widenBias();
+            for (size_t b = 0; b < batch; ++b) {
+                GemmEpilogue ep = epilogue;
+                if (ptrBias)
+                    ep.bias = biasFp32->data() + offsets[b][2];
+                if (packedB)
+                    gemmPacked(transA, m, ptrA + offsets[b][0], lda,
+                               (*packedB)[offsets[b][1] / matB], acc->data(),
+                               ldc, hasEpilogue ? &ep : nullptr);
+                else
+                    gemm(transA, transB, m, n, k, ptrA + offsets[b][0], lda,
+                         ptrB + offsets[b][1], ldb, acc->data(), ldc,
+                         hasEpilogue ? &ep : nullptr);
+                if (half)
+                    fp32ToFp16(acc->data(), ptrC + b * matC, matC);
+                else
+                    fp32ToBf16(acc->data(), ptrC + b * matC, matC);
+            }
+        };
+    }
+
+    KernelFunc prepare(const Operator &_op,
+                       const RuntimeObj *context) const override {
+        return doPrepare(_op, true);
+    }
+
+    void compute(const Operator &_op,
+                 const RuntimeObj *context) const override {
+        doPrepare(_op, false)();
+    }
+};
+
+REGISTER_KERNEL(Device::CPU, OpType::MatMul, BlockedMatmul,
+                "MatmulBlocked_CPU");
+
+} // namespace infini
@@ -1,56 +1,237 @@
 #include "operators/transpose.h"
 #include "core/kernel.h"
+#include <algorithm>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define TRANSPOSE_X86 1
+#endif
 
 namespace infini {
 
-inline Shape idx2Pos(const Shape &shape, size_t idx) {
-    Shape pos = Shape(shape.size(), 0);
-    auto rest = idx, curDimId = shape.size() - 1;
-    while (rest > 0) {
-        pos[curDimId] = rest % shape[curDimId];
-        rest /= shape[curDimId];
-        curDimId--;
+// Reduce a transpose to its minimal equivalent: size-1 dims are dropped and
+// input dims that stay adjacent and in order in the output are merged.
+// `dims` receives the reduced input shape and `perm` the reduced permutation.
+static void reducePermute(const Shape &inDim, const vector<int> &permute,
+                          vector<size_t> &dims, vector<int> &perm) {
+    // Drop size-1 axes and renumber the remaining ones.
+    vector<int> newAxis(inDim.size(), -1);
+    for (size_t i = 0, cnt = 0; i < inDim.size(); ++i)
+        if (inDim[i] != 1)
+            newAxis[i] = cnt++;
+    vector<size_t> keptDims;
+    for (auto d : inDim)
+        if (d != 1)
+            keptDims.emplace_back(d);
+    // Group runs of consecutive input axes in output order.
+    vector<vector<int>> groups;
+    for (auto p : permute) {
+        int axis = newAxis[p];
+        if (axis < 0)
+            continue;
+        if (!groups.empty() && groups.back().back() + 1 == axis)
+            groups.back().emplace_back(axis);
+        else
+            groups.push_back({axis});
+    }
+    // Number the groups by their position in the input.
+    vector<int> order(groups.size());
+    for (size_t i = 0; i < order.size(); ++i)
+        order[i] = i;
+    std::sort(order.begin(), order.end(), [&](int a, int b) {
+        return groups[a].front() < groups[b].front();
+    });
+    dims.assign(groups.size(), 1);
+    perm.assign(groups.size(), 0);
+    for (size_t i = 0; i < order.size(); ++i) {
+        for (auto axis : groups[order[i]])
+            dims[i] *= keptDims[axis];
+        perm[order[i]] = i;
     }
-    return pos;
 }
 
+#ifdef TRANSPOSE_X86
+__attribute__((target("avx"))) static void
+transpose8x8Avx(const float *src, size_t lds, float *dst, size_t ldd) {
+    __m256 r0 = _mm256_loadu_ps(src + 0 * lds);
+    __m256 r1 = _mm256_loadu_ps(src + 1 * lds);
+    __m256 r2 = _mm256_loadu_ps(src + 2 * lds);
+    __m256 r3 = _mm256_loadu_ps(src + 3 * lds);
+    __m256 r4 = _mm256_loadu_ps(src + 4 * lds);
+    __m256 r5 = _mm256_loadu_ps(src + 5 * lds);
+    __m256 r6 = _mm256_loadu_ps(src + 6 * lds);
+    __m256 r7 = _mm256_loadu_ps(src + 7 * lds);
+    __m256 t0 = _mm256_unpacklo_ps(r0, r1), t1 = _mm256_unpackhi_ps(r0, r1);
+    __m256 t2 = _mm256_unpacklo_ps(r2, r3), t3 = _mm256_unpackhi_ps(r2, r3);
+    __m256 t4 = _mm256_unpacklo_ps(r4, r5), t5 = _mm256_unpackhi_ps(r4, r5);
+    __m256 t6 = _mm256_unpacklo_ps(r6, r7), t7 = _mm256_unpackhi_ps(r6, r7);
+    __m256 u0 = _mm256_shuffle_ps(t0, t2, 0x44);
+    __m256 u1 = _mm256_shuffle_ps(t0, t2, 0xEE);
+    __m256 u2 = _mm256_shuffle_ps(t1, t3, 0x44);
+    __m256 u3 = _mm256_shuffle_ps(t1, t3, 0xEE);
+    __m256 u4 = _mm256_shuffle_ps(t4, t6, 0x44);
+    __m256 u5 = _mm256_shuffle_ps(t4, t6, 0xEE);
+    __m256 u6 = _mm256_shuffle_ps(t5, t7, 0x44);
+    __m256 u7 = _mm256_shuffle_ps(t5, t7, 0xEE);
+    _mm256_storeu_ps(dst + 0 * ldd, _mm256_permute2f128_ps(u0, u4, 0x20));
+    _mm256_storeu_ps(dst + 1 * ldd, _mm256_permute2f128_ps(u1, u5, 0x20));
+    _mm256_storeu_ps(dst + 2 * ldd, _mm256_permute2f128_ps(u2, u6, 0x20));
+    _mm256_storeu_ps(dst + 3 * ldd, _mm256_permute2f128_ps(u3, u7, 0x20));
+    _mm256_storeu_ps(dst + 4 * ldd, _mm256_permute2f128_ps(u0, u4, 0x31));
+    _mm256_storeu_ps(dst + 5 * ldd, _mm256_permute2f128_ps(u1, u5, 0x31));
+    _mm256_storeu_ps(dst + 6 * ldd, _mm256_permute2f128_ps(u2, u6, 0x31));
+    _mm256_storeu_ps(dst + 7 * ldd, _mm256_permute2f128_ps(u3, u7, 0x31));
+}
+
+static bool hasAvx() {
+    static const bool avx = [] {
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx");
+    }();
+    return avx;
+}
+#endif
+
 class NaiveTranspose : public CpuKernelWithoutConfig {
+    // Tiles are small enough that the source and destination tile of a
+    // 4-byte type together fit in L1.
+    static constexpr size_t tile = 32;
+    // Below this many elements threading costs more than it saves.
+    static constexpr size_t parallelThreshold = 32768;
+
+    // dst[c * ldd + r] = src[r * lds + c] for r < rows, c < cols
     template <typename T>
-    void doCompute(const Operator &_op, const RuntimeObj *context) const {
-        auto op = as<TransposeObj>(_op);
-        auto inputs = op->getInputs(), outputs = op->getOutputs();
-        const auto &inDim = inputs[0]->getDims();
-        const auto &perm = op->getPermute();
-
-        size_t inSize = inputs[0]->size();
-        auto inPtr = inputs[0]->getRawDataPtr<T *>(),
-             outPtr = outputs[0]->getRawDataPtr<T *>();
-        // #pragma omp parallel for
-        for (size_t inIdx = 0; inIdx < inSize; ++inIdx) {
-            auto posInput = idx2Pos(inDim, inIdx);
-            int outIdx = 0;
-            for (size_t j = 0, jEnd = perm.size(); j < jEnd; ++j) {
-                outIdx = outIdx * inDim[perm[j]] + posInput[perm[j]];
+    static void transposeTile(const T *src, size_t lds, T *dst, size_t ldd,
+                              size_t rows, size_t cols) {
+        size_t r0 = 0, c0 = 0;
+#ifdef TRANSPOSE_X86
+        if constexpr (sizeof(T) == sizeof(float)) {
+            if (hasAvx()) {
+                for (c0 = 0; c0 + 8 <= cols; c0 += 8)
+                    for (r0 = 0; r0 + 8 <= rows; r0 += 8)
+                        transpose8x8Avx(
+                            reinterpret_cast<const float *>(src + r0 * lds + c0),
+                            lds, reinterpret_cast<float *>(dst + c0 * ldd + r0),
+                            ldd);
+                r0 = rows / 8 * 8;
             }
-            outPtr[outIdx] = inPtr[inIdx];
         }
+#endif
+        // Whatever the 8x8 blocks did not cover: the right column strip and
+        // the bottom row strip.
+        for (size_t c = c0; c < cols; ++c)
+            for (size_t r = 0; r < rows; ++r)
+                dst[c * ldd + r] = src[r * lds + c];
+        for (size_t c = 0; c < c0; ++c)
+            for (size_t r = r0; r < rows; ++r)
+                dst[c * ldd + r] = src[r * lds + c];
     }
 
-    void compute(const Operator &_op,
-                 const RuntimeObj *context) const override {
+    template <typename T>
+    KernelFunc doPrepare(const Operator &_op,
+                         const RuntimeObj *context) const {
+        auto op = as<TransposeObj>(_op);
+        auto input = op->getInputs(0), output = op->getOutput();
+        auto inPtr = input->getRawDataPtr<T *>(),
+             outPtr = output->getRawDataPtr<T *>();
+        size_t size = input->size();
+
+        vector<size_t> dims;
+        vector<int> perm;
+        reducePermute(input->getDims(), op->getPermute(), dims, perm);
+        size_t rank = dims.size();
+        if (rank <= 1)
+            return [=]() { std::memcpy(outPtr, inPtr, size * sizeof(T)); };
+
+        vector<size_t> inStride(rank), outDim(rank), outStride(rank),
+            permStride(rank);
+        for (size_t i = rank, p = 1; i > 0; --i) {
+            inStride[i - 1] = p;
+            p *= dims[i - 1];
+        }
+        for (size_t i = rank, p = 1; i > 0; --i) {
+            outDim[i - 1] = dims[perm[i - 1]];
+            outStride[i - 1] = p;
+            p *= outDim[i - 1];
+        }
+        // Input stride along each output axis.
+        for (size_t i = 0; i < rank; ++i)
+            permStride[i] = inStride[perm[i]];
+
+        if ((size_t)perm.back() == rank - 1) {
+            // Innermost axis is kept: copy whole contiguous rows.
+            size_t inner = dims.back(), rows = size / inner;
+            return [=]() {
+#pragma omp parallel for if (size >= parallelThreshold)
+                for (size_t row = 0; row < rows; ++row) {
+                    // Input offset of the row from its output index.
+                    size_t inOffset = 0;
+                    for (size_t i = rank - 1, idx = row; i > 0; --i) {
+                        inOffset += idx % outDim[i - 1] * permStride[i - 1];
+                        idx /= outDim[i - 1];
+                    }
+                    std::memcpy(outPtr + row * inner, inPtr + inOffset,
+                                inner * sizeof(T));
+                }
+            };
+        }
+
+        // Batched 2-D transposes between input axis `p`, which becomes the
+        // innermost output axis, and the innermost input axis, which lands on
+        // output axis `q`.
+        size_t p = perm.back(), q = 0;
+        while ((size_t)perm[q] != rank - 1)
+            ++q;
+        size_t rows = dims[p], cols = dims.back();
+        size_t lds = inStride[p], ldd = outStride[q];
+        size_t rowTiles = (rows + tile - 1) / tile;
+        size_t colTiles = (cols + tile - 1) / tile;
+        size_t tasks = size / (rows * cols) * rowTiles * colTiles;
+        return [=]() {
+#pragma omp parallel for if (size >= parallelThreshold)
+            for (size_t task = 0; task < tasks; ++task) {
+                size_t b = task / (rowTiles * colTiles);
+                size_t r = task / colTiles % rowTiles * tile;
+                size_t c = task % colTiles * tile;
+                // Offsets of batch `b`, which is the index over the output
+                // axes other than `q` and the innermost one.
+                size_t inOffset = 0, outOffset = 0;
+                for (size_t i = rank - 1, idx = b; i > 0; --i) {
+                    if (i - 1 == q)
+                        continue;
+                    inOffset += idx % outDim[i - 1] * permStride[i - 1];
+                    outOffset += idx % outDim[i - 1] * outStride[i - 1];
+                    idx /= outDim[i - 1];
+                }
+                transposeTile(inPtr + inOffset + r * lds + c, lds,
+                              outPtr + outOffset + c * ldd + r, ldd,
+                              std::min(tile, rows - r),
+                              std::min(tile, cols - c));
+            }
+        };
+    }
+
+    KernelFunc prepare(const Operator &_op,
+                       const RuntimeObj *context) const override {
 #define CASE(N)                                                                \
     case N:                                                                    \
-        doCompute<DT<N>::t>(_op, context)
+        return doPrepare<DT<N>::t>(_op, context)
 
         int dataTypeIdx = _op->getDType().getIndex();
         switch (dataTypeIdx) {
-            CASE(1); // DataType::Float32
-            break;
+            CASE(1);  // DataType::Float32
+            CASE(10); // DataType::Float16
             CASE(12); // DataType::UInt32
-            break;
+            CASE(16); // DataType::BFloat16
         default:
             IT_TODO_HALT();
         }
+#undef CASE
+    }
+
+    void compute(const Operator &_op,
+                 const RuntimeObj *context) const override {
+        prepare(_op, context)();
     }
 };
 
@@ -1,5 +1,7 @@
 #include "operators/unary.h"
 #include "core/kernel.h"
+#include "utils/half.h"
+#include <cmath>
 
 namespace infini
 {
@@ -12,90 +14,160 @@ namespace infini
         }
 
         template <typename T>
-        void doCompute(const Operator &_op, const RuntimeObj *context) const
+        KernelFunc doPrepare(const Operator &_op,
+                             const RuntimeObj *context) const
         {
             auto op = as<UnaryObj>(_op);
             T *inptr = op->getInputs(0)->getRawDataPtr<T *>();
             T *outptr = op->getOutput()->getRawDataPtr<T *>();
-
-            auto outDim = op->getOutput()->getDims();
             auto n = op->getOutput()->size();
 
-            T (*_doCompute)
-            (T val);
             switch (op->getOpType().underlying())
             {
             case OpType::Relu:
-                _doCompute = reluCompute<T>;
-                break;
+                return [=]()
+                {
+#pragma omp simd
+                    for (size_t offset = 0; offset < n; offset++)
+                        outptr[offset] = reluCompute(inptr[offset]);
+                };
             default:
                 IT_TODO_HALT();
             }
+        }
+
+        // Half and bfloat16 are computed in fp32 blocks.
+        template <typename Storage>
+        KernelFunc doPrepareReduced(const Operator &_op,
+                                    const RuntimeObj *context) const
+        {
+            auto op = as<UnaryObj>(_op);
+            auto inptr = op->getInputs(0)->getRawDataPtr<uint16_t *>();
+            auto outptr = op->getOutput()->getRawDataPtr<uint16_t *>();
+            auto n = op->getOutput()->size();
 
-            for (size_t offset = 0; offset < n; offset++)
+            switch (op->getOpType().underlying())
             {
-                outptr[offset] = _doCompute(inptr[offset]);
+            case OpType::Relu:
+                return [=]()
+                {
+                    mapFp32<Storage>(inptr, outptr, n,
+                                     [](const float *in, float *out, size_t len)
+                                     {
+#pragma omp simd
+                                         for (size_t i = 0; i < len; i++)
+                                             out[i] = reluCompute(in[i]);
+                                     });
+                };
+            default:
+                IT_TODO_HALT();
             }
         }
 
-        void compute(const Operator &_op,
-                     const RuntimeObj *context) const override
+        KernelFunc prepare(const Operator &_op,
+                           const RuntimeObj *context) const override
         {
 #define CASE(N) \
     case N:     \
-        doCompute<DT<N>::t>(_op, context)
+        return doPrepare<DT<N>::t>(_op, context)
 
             int dataTypeIdx = _op->getDType().getIndex();
             switch (dataTypeIdx)
             {
                 CASE(1); // DataType::Float32
-                break;
                 CASE(12); // DataType::UInt32
-                break;
+            case 10: // DataType::Float16
+                return doPrepareReduced<Float16Storage>(_op, context);
+            case 16: // DataType::BFloat16
+                return doPrepareReduced<BFloat16Storage>(_op, context);
             default:
                 IT_TODO_HALT();
             }
+#undef CASE
+        }
+
+        void compute(const Operator &_op,
+                     const RuntimeObj *context) const override
+        {
+            prepare(_op, context)();
         }
     };
 
     class Clip : public CpuKernelWithoutConfig
     {
         template <typename T>
-        void doCompute(const Operator &_op, const RuntimeObj *context) const
+        KernelFunc doPrepare(const Operator &_op,
+                             const RuntimeObj *context) const
         {
             auto op = as<ClipObj>(_op);
             T *inptr = op->getInputs(0)->getRawDataPtr<T *>();
             T *outptr = op->getOutput()->getRawDataPtr<T *>();
             auto minValue = op->getMin();
             auto maxValue = op->getMax();
+            auto n = op->getOutput()->size();
+
+            return [=]()
+            {
+                for (size_t offset = 0; offset < n; offset++)
+                {
+                    auto val = inptr[offset];
+                    outptr[offset] = (minValue && val < *minValue)   ? *minValue
+                                     : (maxValue && val > *maxValue) ? *maxValue
+                                                                     : val;
+                }
+            };
+        }
 
+        // Half and bfloat16 are clipped in fp32 blocks.
+        template <typename Storage>
+        KernelFunc doPrepareReduced(const Operator &_op,
+                                    const RuntimeObj *context) const
+        {
+            auto op = as<ClipObj>(_op);
+            auto inptr = op->getInputs(0)->getRawDataPtr<uint16_t *>();
+            auto outptr = op->getOutput()->getRawDataPtr<uint16_t *>();
+            float lo = op->getMin().value_or(-INFINITY);
+            float hi = op->getMax().value_or(INFINITY);
             auto n = op->getOutput()->size();
-            for (size_t offset = 0; offset < n; offset++)
+
+            return [=]()
             {
-                auto val = *inptr++;
-                *outptr++ = (minValue && val < *minValue)   ? *minValue
-                            : (maxValue && val > *maxValue) ? *maxValue
-                                                            : val;
-            }
+                mapFp32<Storage>(inptr, outptr, n,
+                                 [=](const float *in, float *out, size_t len)
+                                 {
+#pragma omp simd
+                                     for (size_t i = 0; i < len; i++)
+                                         out[i] = std::min(std::max(in[i], lo), hi);
+                                 });
+            };
         }
 
-        void compute(const Operator &_op,
-                     const RuntimeObj *context) const override
+        KernelFunc prepare(const Operator &_op,
+                           const RuntimeObj *context) const override
         {
 #define CASE(N) \
     case N:     \
-        doCompute<DT<N>::t>(_op, context)
+        return doPrepare<DT<N>::t>(_op, context)
 
             int dataTypeIdx = _op->getDType().getIndex();
             switch (dataTypeIdx)
             {
                 CASE(1); // DataType::Float32
-                break;
                 CASE(12); // DataType::UInt32
-                break;
+            case 10: // DataType::Float16
+                return doPrepareReduced<Float16Storage>(_op, context);
+            case 16: // DataType::BFloat16
+                return doPrepareReduced<BFloat16Storage>(_op, context);
             default:
                 IT_TODO_HALT();
             }
+#undef CASE
+        }
+
+        void compute(const Operator &_op,
+                     const RuntimeObj *context) const override
+        {
+            prepare(_op, context)();
         }
     };
 
@@ -0,0 +1,86 @@
+#include "operators/fused_element_wise.h"
+#include "utils/operator_utils.h"
+
+namespace infini
+{
+    FusedElementWiseObj::FusedElementWiseObj(GraphObj *graph, TensorVec inputs,
+                                             Tensor output, vector<Step> steps)
+        : OperatorObj(OpType::FusedElementWise, inputs, {output}),
+          steps(std::move(steps))
+    {
+        IT_ASSERT(checkValid(graph));
+    }
+
+    bool FusedElementWiseObj::isFusible(OpType type)
+    {
+        switch (type.underlying())
+        {
+        case OpType::Add:
+        case OpType::Sub:
+        case OpType::Mul:
+        case OpType::Div:
+        case OpType::Relu:
+        case OpType::Clip:
+        case OpType::FusedElementWise:
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    optional<vector<Shape>>
+    FusedElementWiseObj::inferShape(const TensorVec &inputs)
+    {
+        if (steps.empty())
+            return {};
+        vector<Shape> shapes;
+        auto shapeOf = [&](int operand) -> optional<Shape>
+        {
+            if (operand >= 0)
+            {
+                if ((size_t)operand < inputs.size())
+                    return inputs[operand]->getDims();
+                return {};
+            }
+            auto step = operandStep(operand);
+            if (step < shapes.size())
+                return shapes[step];
+            return {};
+        };
+        for (const auto &step : steps)
+        {
+            auto lhs = shapeOf(step.lhs);
+            if (!lhs)
+                return {};
+            if (step.type == OpType::Relu || step.type == OpType::Clip)
+            {
+                shapes.emplace_back(*lhs);
+                continue;
+            }
+            auto rhs = shapeOf(step.rhs);
+            if (!rhs)
+                return {};
+            shapes.emplace_back(infer_broadcast(*lhs, *rhs));
+        }
+        // Intermediates are evaluated block by block along with the output,
+        // so every step has to produce the full output shape.
+        for (const auto &shape : shapes)
+            if (shape != shapes.back())
+                return {};
+        return {{shapes.back()}};
+    }
+
+    std::string FusedElementWiseObj::toString() const
+    {
+        std::ostringstream os;
+        os << type.toString() << "[" << getGuid() << "]";
+        os << "(";
+        for (const auto &step : steps)
+            os << step.type.toString() << ",";
+        for (size_t i = 0; i < inputs.size(); ++i)
+            os << "input" << i << "=" << inputs[i]->getGuid() << ",";
+        os << "output=" << outputs[0]->getGuid() << ")";
+        return os.str();
+    }
+
+}; // namespace infini
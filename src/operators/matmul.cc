@@ -1,24 +1,58 @@
 #include "operators/matmul.h"
+#include "utils/log.h"
 
 namespace infini
 {
     Shape infer_broadcast(const Shape &A, const Shape &B);
 
     MatmulObj::MatmulObj(GraphObj *graph, Tensor A, Tensor B, Tensor C, bool transA,
-                         bool transB)
-        : OperatorObj(OpType::MatMul, TensorVec{A, B}, {C}),
-          transA(transA), transB(transB)
+                         bool transB, Tensor bias,
+                         std::optional<MatmulQuantization> quant)
+        : OperatorObj(OpType::MatMul,
+                      bias ? TensorVec{A, B, bias} : TensorVec{A, B}, {C}),
+          transA(transA), transB(transB), quant(std::move(quant))
     {
         IT_ASSERT(checkValid(graph));
     }
 
+    void MatmulObj::clampOutput(std::optional<float> min,
+                                std::optional<float> max)
+    {
+        // clamp(clamp(x, a, b), c, d) == clamp(x, clamp(a, c, d), clamp(b, c, d))
+        auto clamp = [&](std::optional<float> v) -> std::optional<float>
+        {
+            if (!v)
+                return v;
+            if (min && *v < *min)
+                return min;
+            if (max && *v > *max)
+                return max;
+            return v;
+        };
+        auto newMin = minValue ? clamp(minValue) : min;
+        auto newMax = maxValue ? clamp(maxValue) : max;
+        minValue = newMin;
+        maxValue = newMax;
+    }
+
     string MatmulObj::toString() const
     {
         std::ostringstream os;
         os << "Matmul([" << (transA ? "A^T" : "A") << "," << (transB ? "B^T" : "B]")
            << ",A=" << inputs[0]->getGuid()
            << ",B=" << inputs[1]->getGuid() << ",C=" << outputs[0]->getGuid()
-           << ",mnk=[" << m << "," << n << "," << k << "])";
+           << ",mnk=[" << m << "," << n << "," << k << "]";
+        if (auto bias = getBias())
+            os << ",bias=" << bias->getGuid();
+        if (minValue)
+            os << ",min=" << *minValue;
+        if (maxValue)
+            os << ",max=" << *maxValue;
+        if (quant)
+            os << ",quant=[A:" << quant->scaleA << "@" << quant->zeroA
+               << ",B:" << quant->scaleB.size() << " scales,C:"
+               << quant->outType.toString() << "]";
+        os << ")";
         return os.str();
     }
 
@@ -28,7 +62,7 @@ namespace infini
         // TODO：返回经过 matmul 操作后的 shape
         // REF: https://github.com/onnx/onnx/blob/main/docs/Operators.md#gemm
         // =================================== 作业 ===================================
-        IT_ASSERT(inputs.size() == 2);
+        IT_ASSERT(inputs.size() == 2 || inputs.size() == 3);
         const auto &A = inputs[0];
         const auto &B = inputs[1];
         const auto &shapeA = A->getDims();
@@ -54,7 +88,10 @@ namespace infini
         }
         // 验证矩阵乘法维度匹配
         if(a_cols != b_rows){
-            printf("[ERROR] Matmul: matrix dimension mismatch,a shape: rows, %d,cols,%d, b shape:rows,%d,cols,%d \n",a_rows, a_cols, b_rows,b_cols);
+            IT_LOG(Error) << "Matmul: matrix dimension mismatch, a shape: rows "
+                          << a_rows << ", cols " << a_cols
+                          << ", b shape: rows " << b_rows << ", cols "
+                          << b_cols;
             return std::nullopt;
         }
         // 提取前导维度（batch部分）
@@ -69,9 +106,40 @@ namespace infini
         // 广播前导维度
         Shape batch_shape = infer_broadcast(batchA, batchB);
 
+        m = a_rows;
+        n = b_cols;
+        k = a_cols;
+
         // 组合最终输出形状
         Shape output_shape = batch_shape;
         output_shape.insert(output_shape.end(), {a_rows, b_cols});
+        // bias 必须能广播到输出形状
+        if (inputs.size() == 3 &&
+            infer_broadcast(output_shape, inputs[2]->getDims()) != output_shape)
+            return std::nullopt;
+        // 量化 matmul：A 为 uint8，B 为 int8，bias 为 float；B 的 scale 为
+        // 整个张量一个或每个输出列一个
+        if (quant)
+        {
+            if (!(A->getDType() == DataType::UInt8) ||
+                !(B->getDType() == DataType::Int8) ||
+                (inputs.size() == 3 &&
+                 !(inputs[2]->getDType() == DataType::Float32)))
+                return std::nullopt;
+            if (quant->scaleB.size() != 1 && (int)quant->scaleB.size() != n)
+                return std::nullopt;
+            const auto &outType = quant->outType;
+            if (!(outType == DataType::Float32 || outType == DataType::UInt8 ||
+                  outType == DataType::Int8))
+                return std::nullopt;
+        }
         return {{output_shape}};
         }
+
+    vector<DataType> MatmulObj::inferDataType(const TensorVec &inputs) const
+    {
+        if (quant)
+            return {quant->outType};
+        return OperatorObj::inferDataType(inputs);
+    }
 } // namespace infini
\ No newline at end of file
@@ -0,0 +1,548 @@
+#include "utils/gemm.h"
+#include "utils/half.h"
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define GEMM_X86 1
+#endif
+
+namespace infini {
+
+namespace {
+
+// Register tile computed by one micro-kernel call: MR rows of A times NR
+// columns of B. 6x16 keeps 12 ymm accumulators plus 2 B vectors and 1 A
+// broadcast in the 16 AVX2 registers.
+constexpr int MR = 6;
+constexpr int NR = 16;
+// Cache blocking: a KC x NR panel of B stays in L1, an MC x KC block of A in
+// L2 and the KC x NC block of B in L3.
+constexpr int MC = 144;
+constexpr int KC = 256;
+constexpr int NC = 3072;
+
+using MicroKernel = void (*)(int kc, const float *a, const float *b, float *c,
+                             size_t ldc, bool accumulate);
+
+void microKernelGeneric(int kc, const float *a, const float *b, float *c,
+                        size_t ldc, bool accumulate) {
+    float acc[MR][NR] = {};
+    for (int p = 0; p < kc; ++p, a += MR, b += NR)
+        for (int r = 0; r < MR; ++r)
+            for (int j = 0; j < NR; ++j)
+                acc[r][j] += a[r] * b[j];
+    for (int r = 0; r < MR; ++r) {
+        float *row = c + r * ldc;
+        for (int j = 0; j < NR; ++j)
+            row[j] = accumulate ? row[j] + acc[r][j] : acc[r][j];
+    }
+}
+
+#ifdef GEMM_X86
+__attribute__((target("avx2,fma"))) void
+microKernelAvx2(int kc, const float *a, const float *b, float *c, size_t ldc,
+                bool accumulate) {
+    __m256 c00 = _mm256_setzero_ps(), c01 = _mm256_setzero_ps();
+    __m256 c10 = _mm256_setzero_ps(), c11 = _mm256_setzero_ps();
+    __m256 c20 = _mm256_setzero_ps(), c21 = _mm256_setzero_ps();
+    __m256 c30 = _mm256_setzero_ps(), c31 = _mm256_setzero_ps();
+    __m256 c40 = _mm256_setzero_ps(), c41 = _mm256_setzero_ps();
+    __m256 c50 = _mm256_setzero_ps(), c51 = _mm256_setzero_ps();
+    for (int p = 0; p < kc; ++p, a += MR, b += NR) {
+        __m256 b0 = _mm256_loadu_ps(b), b1 = _mm256_loadu_ps(b + 8), av;
+#define FMA_ROW(R)                                                             \
+    av = _mm256_broadcast_ss(a + R);                                           \
+    c##R##0 = _mm256_fmadd_ps(av, b0, c##R##0);                                \
+    c##R##1 = _mm256_fmadd_ps(av, b1, c##R##1);
+        FMA_ROW(0) FMA_ROW(1) FMA_ROW(2) FMA_ROW(3) FMA_ROW(4) FMA_ROW(5)
+#undef FMA_ROW
+    }
+#define STORE_ROW(R)                                                           \
+    {                                                                          \
+        float *row = c + R * ldc;                                              \
+        if (accumulate) {                                                      \
+            c##R##0 = _mm256_add_ps(_mm256_loadu_ps(row), c##R##0);           \
+            c##R##1 = _mm256_add_ps(_mm256_loadu_ps(row + 8), c##R##1);        \
+        }                                                                      \
+        _mm256_storeu_ps(row, c##R##0);                                        \
+        _mm256_storeu_ps(row + 8, c##R##1);                                    \
+    }
+    STORE_ROW(0) STORE_ROW(1) STORE_ROW(2) STORE_ROW(3) STORE_ROW(4)
+    STORE_ROW(5)
+#undef STORE_ROW
+}
+#endif
+
+MicroKernel selectMicroKernel() {
+#ifdef GEMM_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+        return microKernelAvx2;
+#endif
+    return microKernelGeneric;
+}
+
+// Storage of fp32 operands, alongside Float16Storage and BFloat16Storage:
+// packing widens every operand to fp32 so one micro-kernel serves them all.
+struct Fp32Storage {
+    static float load(float val) { return val; }
+    static void load(const float *src, float *dst, size_t n) {
+        std::memcpy(dst, src, n * sizeof(float));
+    }
+};
+
+// Pack rows [0, m) x cols [pc, pc + kc) of op(A) into MR-row panels, each
+// stored k-major so the micro-kernel reads MR consecutive values per step.
+// The last panel is zero padded.
+template <typename Storage, typename T>
+void packA(bool transA, const T *A, size_t lda, int m, int pc, int kc,
+           float *dst) {
+    int panels = (m + MR - 1) / MR;
+#pragma omp parallel for
+    for (int panel = 0; panel < panels; ++panel) {
+        int i0 = panel * MR, mr = std::min(MR, m - i0);
+        float *out = dst + (size_t)i0 * kc;
+        for (int p = 0; p < kc; ++p, out += MR) {
+            size_t col = pc + p;
+            for (int r = 0; r < mr; ++r)
+                out[r] = Storage::load(transA ? A[col * lda + i0 + r]
+                                              : A[(size_t)(i0 + r) * lda + col]);
+            for (int r = mr; r < MR; ++r)
+                out[r] = 0.f;
+        }
+    }
+}
+
+// Pack rows [pc, pc + kc) x cols [jc, jc + nc) of op(B) into NR-column
+// panels, each stored k-major. The last panel is zero padded.
+template <typename Storage, typename T>
+void packB(bool transB, const T *B, size_t ldb, int pc, int kc, int jc,
+           int nc, float *dst) {
+    int panels = (nc + NR - 1) / NR;
+#pragma omp parallel for
+    for (int panel = 0; panel < panels; ++panel) {
+        int j0 = panel * NR, nr = std::min(NR, nc - j0);
+        size_t col = jc + j0;
+        float *out = dst + (size_t)j0 * kc;
+        for (int p = 0; p < kc; ++p, out += NR) {
+            size_t row = pc + p;
+            if (!transB) {
+                Storage::load(B + row * ldb + col, out, nr);
+            } else {
+                for (int j = 0; j < nr; ++j)
+                    out[j] = Storage::load(B[(col + j) * ldb + row]);
+            }
+            for (int j = nr; j < NR; ++j)
+                out[j] = 0.f;
+        }
+    }
+}
+
+// Apply the epilogue to the mr x nr tile of C at (row, col).
+void applyEpilogue(const GemmEpilogue &ep, float *c, size_t ldc, int row,
+                   int col, int mr, int nr) {
+    float lo = ep.lo, hi = ep.hi;
+    for (int r = 0; r < mr; ++r) {
+        float *out = c + r * ldc;
+        if (!ep.bias) {
+#pragma omp simd
+            for (int j = 0; j < nr; ++j)
+                out[j] = std::min(std::max(out[j], lo), hi);
+            continue;
+        }
+        const float *bias = ep.bias + (row + r) * ep.biasRowStride +
+                            col * ep.biasColStride;
+        if (ep.biasColStride == 0) {
+            float val = *bias;
+#pragma omp simd
+            for (int j = 0; j < nr; ++j)
+                out[j] = std::min(std::max(out[j] + val, lo), hi);
+        } else {
+#pragma omp simd
+            for (int j = 0; j < nr; ++j)
+                out[j] = std::min(std::max(out[j] + bias[j], lo), hi);
+        }
+    }
+}
+
+// The integer kernels take operands in groups of G consecutive k values:
+// each step multiplies MR groups of A by NR groups of B and adds the G
+// products of every pair to the int32 accumulators, so no partial sum is
+// ever saturated. With VNNI the uint8/int8 bytes are used as they are, in
+// groups of 4 (vpdpbusd); otherwise they are widened to int16 pairs
+// (vpmaddwd).
+constexpr int KCI = 512; // k values per block, a multiple of 4
+
+template <typename TA, typename TB>
+using IntMicroKernel = void (*)(int kg, const TA *a, const TB *b, int32_t *c,
+                                size_t ldc, bool accumulate);
+
+template <int G, typename TA, typename TB>
+void intMicroKernelGeneric(int kg, const TA *a, const TB *b, int32_t *c,
+                           size_t ldc, bool accumulate) {
+    int32_t acc[MR][NR] = {};
+    for (int p = 0; p < kg; ++p, a += G * MR, b += G * NR)
+        for (int r = 0; r < MR; ++r)
+            for (int j = 0; j < NR; ++j)
+                for (int h = 0; h < G; ++h)
+                    acc[r][j] += int32_t(a[G * r + h]) * b[G * j + h];
+    for (int r = 0; r < MR; ++r) {
+        int32_t *row = c + r * ldc;
+        for (int j = 0; j < NR; ++j)
+            row[j] = accumulate ? row[j] + acc[r][j] : acc[r][j];
+    }
+}
+
+#ifdef GEMM_X86
+// Same register tiling as microKernelAvx2, with the accumulators named so
+// they stay in registers. A group of A is 4 bytes either way and is
+// broadcast as one int32; DOT(acc, a, b) adds the grouped products of a and
+// b to acc.
+#define INT_DOT_ROW(R, DOT)                                                    \
+    {                                                                          \
+        int32_t group;                                                         \
+        std::memcpy(&group, a + G * R, sizeof(group));                         \
+        __m256i av = _mm256_set1_epi32(group);                                 \
+        c##R##0 = DOT(c##R##0, av, b0);                                        \
+        c##R##1 = DOT(c##R##1, av, b1);                                        \
+    }
+#define INT_STORE_ROW(R)                                                       \
+    {                                                                          \
+        __m256i *row = reinterpret_cast<__m256i *>(c + R * ldc);               \
+        if (accumulate) {                                                      \
+            c##R##0 = _mm256_add_epi32(_mm256_loadu_si256(row), c##R##0);      \
+            c##R##1 = _mm256_add_epi32(_mm256_loadu_si256(row + 1), c##R##1);  \
+        }                                                                      \
+        _mm256_storeu_si256(row, c##R##0);                                     \
+        _mm256_storeu_si256(row + 1, c##R##1);                                 \
+    }
+#define INT_MICRO_KERNEL(NAME, TARGET, TA, TB, DOT)                            \
+    __attribute__((target(TARGET))) void NAME(                                 \
+        int kg, const TA *a, const TB *b, int32_t *c, size_t ldc,              \
+        bool accumulate) {                                                     \
+        constexpr int G = 4 / sizeof(TA);                                      \
+        __m256i c00 = _mm256_setzero_si256(), c01 = c00, c10 = c00,            \
+                c11 = c00, c20 = c00, c21 = c00, c30 = c00, c31 = c00,         \
+                c40 = c00, c41 = c00, c50 = c00, c51 = c00;                    \
+        for (int p = 0; p < kg; ++p, a += G * MR, b += G * NR) {               \
+            auto pb = reinterpret_cast<const __m256i *>(b);                    \
+            __m256i b0 = _mm256_loadu_si256(pb);                               \
+            __m256i b1 = _mm256_loadu_si256(pb + 1);                           \
+            INT_DOT_ROW(0, DOT) INT_DOT_ROW(1, DOT) INT_DOT_ROW(2, DOT)        \
+            INT_DOT_ROW(3, DOT) INT_DOT_ROW(4, DOT) INT_DOT_ROW(5, DOT)        \
+        }                                                                      \
+        INT_STORE_ROW(0) INT_STORE_ROW(1) INT_STORE_ROW(2)                     \
+        INT_STORE_ROW(3) INT_STORE_ROW(4) INT_STORE_ROW(5)                     \
+    }
+
+#define DOT_AVX2(acc, a, b) _mm256_add_epi32(acc, _mm256_madd_epi16(a, b))
+#define DOT_AVXVNNI(acc, a, b) _mm256_dpbusd_avx_epi32(acc, a, b)
+#define DOT_AVX512VNNI(acc, a, b) _mm256_dpbusd_epi32(acc, a, b)
+INT_MICRO_KERNEL(intMicroKernelAvx2, "avx2", int16_t, int16_t, DOT_AVX2)
+INT_MICRO_KERNEL(intMicroKernelAvxVnni, "avx2,avxvnni", uint8_t, int8_t,
+                 DOT_AVXVNNI)
+INT_MICRO_KERNEL(intMicroKernelAvx512Vnni, "avx2,avx512vl,avx512vnni",
+                 uint8_t, int8_t, DOT_AVX512VNNI)
+#undef DOT_AVX2
+#undef DOT_AVXVNNI
+#undef DOT_AVX512VNNI
+#undef INT_MICRO_KERNEL
+#undef INT_STORE_ROW
+#undef INT_DOT_ROW
+#endif
+
+// Pack rows [0, m) x cols [pc, pc + kc) of op(A) into MR-row panels of
+// groups of G along k. A partial group and the last panel are zero padded.
+template <int G, typename T>
+void packIntA(bool transA, const uint8_t *A, size_t lda, int m, int pc,
+              int kc, T *dst) {
+    int panels = (m + MR - 1) / MR, kg = (kc + G - 1) / G;
+#pragma omp parallel for
+    for (int panel = 0; panel < panels; ++panel) {
+        int i0 = panel * MR, mr = std::min(MR, m - i0);
+        T *out = dst + (size_t)i0 * G * kg;
+        std::fill_n(out, (size_t)MR * G * kg, 0);
+        for (int r = 0; r < mr; ++r)
+            for (int p = 0; p < kc; ++p) {
+                size_t col = pc + p;
+                out[p / G * G * MR + G * r + p % G] =
+                    transA ? A[col * lda + i0 + r]
+                           : A[(size_t)(i0 + r) * lda + col];
+            }
+    }
+}
+
+// Pack rows [pc, pc + kc) x cols [jc, jc + nc) of op(B) into NR-column
+// panels of groups of G along k, zero padded like packIntA.
+template <int G, typename T>
+void packIntB(bool transB, const int8_t *B, size_t ldb, int pc, int kc,
+              int jc, int nc, T *dst) {
+    int panels = (nc + NR - 1) / NR, kg = (kc + G - 1) / G;
+#pragma omp parallel for
+    for (int panel = 0; panel < panels; ++panel) {
+        int j0 = panel * NR, nr = std::min(NR, nc - j0);
+        size_t col = jc + j0;
+        T *out = dst + (size_t)j0 * G * kg;
+        std::fill_n(out, (size_t)NR * G * kg, 0);
+        for (int p = 0; p < kc; ++p) {
+            size_t row = pc + p;
+            T *group = out + p / G * G * NR + p % G;
+            if (!transB) {
+                const int8_t *src = B + row * ldb + col;
+                for (int j = 0; j < nr; ++j)
+                    group[G * j] = src[j];
+            } else {
+                for (int j = 0; j < nr; ++j)
+                    group[G * j] = B[(col + j) * ldb + row];
+            }
+        }
+    }
+}
+
+template <int G, typename TA, typename TB>
+void igemmPacked(IntMicroKernel<TA, TB> microKernel, bool transA, bool transB,
+                 int m, int n, int k, const uint8_t *A, size_t lda,
+                 const int8_t *B, size_t ldb, int32_t *C, size_t ldc) {
+    thread_local std::vector<TA> bufA;
+    thread_local std::vector<TB> bufB;
+    int mPadded = (m + MR - 1) / MR * MR;
+    bufA.resize(std::max(bufA.size(), (size_t)mPadded * KCI));
+    bufB.resize(std::max(bufB.size(), (size_t)KCI * NC));
+    TA *packedA = bufA.data();
+    TB *packedB = bufB.data();
+
+    for (int jc = 0; jc < n; jc += NC) {
+        int nc = std::min(NC, n - jc);
+        for (int pc = 0; pc < k; pc += KCI) {
+            int kc = std::min(KCI, k - pc), kg = (kc + G - 1) / G;
+            bool accumulate = pc > 0;
+            packIntB<G>(transB, B, ldb, pc, kc, jc, nc, packedB);
+            packIntA<G>(transA, A, lda, m, pc, kc, packedA);
+
+            int mBlocks = (m + MC - 1) / MC, nPanels = (nc + NR - 1) / NR;
+#pragma omp parallel for collapse(2)
+            for (int ib = 0; ib < mBlocks; ++ib) {
+                for (int jb = 0; jb < nPanels; ++jb) {
+                    int jr = jb * NR, nr = std::min(NR, nc - jr);
+                    const TB *b = packedB + (size_t)jr * G * kg;
+                    for (int ir = ib * MC; ir < std::min(m, (ib + 1) * MC);
+                         ir += MR) {
+                        int mr = std::min(MR, m - ir);
+                        const TA *a = packedA + (size_t)ir * G * kg;
+                        int32_t *c = C + ir * ldc + jc + jr;
+                        if (mr == MR && nr == NR) {
+                            microKernel(kg, a, b, c, ldc, accumulate);
+                            continue;
+                        }
+                        int32_t tile[MR * NR];
+                        microKernel(kg, a, b, tile, NR, false);
+                        for (int r = 0; r < mr; ++r)
+                            for (int j = 0; j < nr; ++j)
+                                c[r * ldc + j] =
+                                    accumulate
+                                        ? c[r * ldc + j] + tile[r * NR + j]
+                                        : tile[r * NR + j];
+                    }
+                }
+            }
+        }
+    }
+}
+
+// Pack all of op(B) in the blocks gemm visits, jc outer and pc inner, each
+// block laid out as packB leaves it.
+template <typename Storage, typename T>
+GemmPackedB packAllB(bool transB, int k, int n, const T *B, size_t ldb) {
+    GemmPackedB packed;
+    packed.k = k;
+    packed.n = n;
+    size_t nPadded = 0;
+    for (int jc = 0; jc < n; jc += NC)
+        nPadded += (std::min(NC, n - jc) + NR - 1) / NR * NR;
+    packed.data.resize(nPadded * std::max(k, 0));
+    float *dst = packed.data.data();
+    for (int jc = 0; jc < n; jc += NC) {
+        int nc = std::min(NC, n - jc);
+        for (int pc = 0; pc < k; pc += KC) {
+            int kc = std::min(KC, k - pc);
+            packB<Storage>(transB, B, ldb, pc, kc, jc, nc, dst);
+            dst += (size_t)(nc + NR - 1) / NR * NR * kc;
+        }
+    }
+    return packed;
+}
+
+// B is packed on the fly from `B`, or read from `prepackedB` when it is given
+// (see packAllB), in which case `B` and `transB` are unused.
+template <typename Storage, typename T>
+void gemm(bool transA, bool transB, int m, int n, int k, const T *A,
+          size_t lda, const T *B, size_t ldb, float *C, size_t ldc,
+          const GemmEpilogue *epilogue,
+          const float *prepackedB = nullptr) {
+    if (m <= 0 || n <= 0)
+        return;
+    if (k <= 0) {
+        for (int i = 0; i < m; ++i)
+            std::fill_n(C + i * ldc, n, 0.f);
+        if (epilogue)
+            applyEpilogue(*epilogue, C, ldc, 0, 0, m, n);
+        return;
+    }
+    static const MicroKernel microKernel = selectMicroKernel();
+    // Packing buffers are reused across calls so that repeated inference does
+    // not touch the system allocator.
+    thread_local std::vector<float> bufA, bufB;
+    int mPadded = (m + MR - 1) / MR * MR;
+    bufA.resize(std::max(bufA.size(), (size_t)mPadded * KC));
+    if (!prepackedB)
+        bufB.resize(std::max(bufB.size(), (size_t)KC * NC));
+    float *packedA = bufA.data(), *packedB = bufB.data();
+    const float *nextB = prepackedB;
+
+    for (int jc = 0; jc < n; jc += NC) {
+        int nc = std::min(NC, n - jc);
+        for (int pc = 0; pc < k; pc += KC) {
+            int kc = std::min(KC, k - pc);
+            bool accumulate = pc > 0;
+            // The epilogue runs on the tiles of the last k block
+            bool last = pc + kc == k;
+            const float *blockB = packedB;
+            if (nextB) {
+                blockB = nextB;
+                nextB += (size_t)(nc + NR - 1) / NR * NR * kc;
+            } else {
+                packB<Storage>(transB, B, ldb, pc, kc, jc, nc, packedB);
+            }
+            packA<Storage>(transA, A, lda, m, pc, kc, packedA);
+
+            int mBlocks = (m + MC - 1) / MC, nPanels = (nc + NR - 1) / NR;
+#pragma omp parallel for collapse(2)
+            for (int ib = 0; ib < mBlocks; ++ib) {
+                for (int jb = 0; jb < nPanels; ++jb) {
+                    int jr = jb * NR, nr = std::min(NR, nc - jr);
+                    const float *b = blockB + (size_t)jr * kc;
+                    for (int ir = ib * MC; ir < std::min(m, (ib + 1) * MC);
+                         ir += MR) {
+                        int mr = std::min(MR, m - ir);
+                        const float *a = packedA + (size_t)ir * kc;
+                        float *c = C + ir * ldc + jc + jr;
+                        if (mr == MR && nr == NR) {
+                            microKernel(kc, a, b, c, ldc, accumulate);
+                        } else {
+                            // Edge tile: compute the full tile aside and copy
+                            // back only the valid part.
+                            float tile[MR * NR];
+                            microKernel(kc, a, b, tile, NR, false);
+                            for (int r = 0; r < mr; ++r)
+                                for (int j = 0; j < nr; ++j)
+                                    c[r * ldc + j] =
+                                        accumulate
+                                            ? c[r * ldc + j] + tile[r * NR + j]
+                                            : tile[r * NR + j];
+                        }
+                        if (last && epilogue)
+                            applyEpilogue(*epilogue, c, ldc, ir, jc + jr, mr,
+                                          nr);
+                    }
+                }
+            }
+        }
+    }
+}
+
+} // namespace
+
+void sgemm(bool transA, bool transB, int m, int n, int k, const float *A,
+           size_t lda, const float *B, size_t ldb, float *C, size_t ldc,
+           const GemmEpilogue *epilogue) {
+    gemm<Fp32Storage>(transA, transB, m, n, k, A, lda, B, ldb, C, ldc,
+                      epilogue);
+}
+
+void hgemm(bool transA, bool transB, int m, int n, int k, const uint16_t *A,
+           size_t lda, const uint16_t *B, size_t ldb, float *C, size_t ldc,
+           const GemmEpilogue *epilogue) {
+    gemm<Float16Storage>(transA, transB, m, n, k, A, lda, B, ldb, C, ldc,
+                         epilogue);
+}
+
+void bf16gemm(bool transA, bool transB, int m, int n, int k,
+              const uint16_t *A, size_t lda, const uint16_t *B, size_t ldb,
+              float *C, size_t ldc, const GemmEpilogue *epilogue) {
+    gemm<BFloat16Storage>(transA, transB, m, n, k, A, lda, B, ldb, C, ldc,
+                          epilogue);
+}
+
+GemmPackedB sgemmPackB(bool transB, int k, int n, const float *B,
+                       size_t ldb) {
+    return packAllB<Fp32Storage>(transB, k, n, B, ldb);
+}
+
+GemmPackedB hgemmPackB(bool transB, int k, int n, const uint16_t *B,
+                       size_t ldb) {
+    return packAllB<Float16Storage>(transB, k, n, B, ldb);
+}
+
+GemmPackedB bf16gemmPackB(bool transB, int k, int n, const uint16_t *B,
+                          size_t ldb) {
+    return packAllB<BFloat16Storage>(transB, k, n, B, ldb);
+}
+
+void sgemmPacked(bool transA, int m, const float *A, size_t lda,
+                 const GemmPackedB &B, float *C, size_t ldc,
+                 const GemmEpilogue *epilogue) {
+    gemm<Fp32Storage, float>(transA, false, m, B.n, B.k, A, lda, nullptr, 0,
+                             C, ldc, epilogue, B.data.data());
+}
+
+void hgemmPacked(bool transA, int m, const uint16_t *A, size_t lda,
+                 const GemmPackedB &B, float *C, size_t ldc,
+                 const GemmEpilogue *epilogue) {
+    gemm<Float16Storage, uint16_t>(transA, false, m, B.n, B.k, A, lda,
+                                   nullptr, 0, C, ldc, epilogue,
+                                   B.data.data());
+}
+
+void bf16gemmPacked(bool transA, int m, const uint16_t *A, size_t lda,
+                    const GemmPackedB &B, float *C, size_t ldc,
+                    const GemmEpilogue *epilogue) {
+    gemm<BFloat16Storage, uint16_t>(transA, false, m, B.n, B.k, A, lda,
+                                    nullptr, 0, C, ldc, epilogue,
+                                    B.data.data());
+}
+
+void igemm(bool transA, bool transB, int m, int n, int k, const uint8_t *A,
+           size_t lda, const int8_t *B, size_t ldb, int32_t *C, size_t ldc) {
+    if (m <= 0 || n <= 0)
+        return;
+    if (k <= 0) {
+        for (int i = 0; i < m; ++i)
+            std::fill_n(C + i * ldc, n, 0);
+        return;
+    }
+#ifdef GEMM_X86
+    static const IntMicroKernel<uint8_t, int8_t> vnniKernel = [] {
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avxvnni"))
+            return intMicroKernelAvxVnni;
+        if (__builtin_cpu_supports("avx512vnni") &&
+            __builtin_cpu_supports("avx512vl"))
+            return intMicroKernelAvx512Vnni;
+        return (IntMicroKernel<uint8_t, int8_t>) nullptr;
+    }();
+    if (vnniKernel)
+        return igemmPacked<4>(vnniKernel, transA, transB, m, n, k, A, lda, B,
+                              ldb, C, ldc);
+    static const bool avx2 = __builtin_cpu_supports("avx2");
+    if (avx2)
+        return igemmPacked<2>(intMicroKernelAvx2, transA, transB, m, n, k, A,
+                              lda, B, ldb, C, ldc);
+#endif
+    igemmPacked<2>(intMicroKernelGeneric<2, int16_t, int16_t>, transA, transB,
+                   m, n, k, A, lda, B, ldb, C, ldc);
+}
+
+} // namespace infini
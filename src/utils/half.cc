@@ -0,0 +1,131 @@
+#include "utils/half.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HALF_X86 1
+#endif
+
+namespace infini {
+
+namespace {
+
+#ifdef HALF_X86
+bool hasF16c() {
+    static const bool f16c = [] {
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx") && __builtin_cpu_supports("f16c");
+    }();
+    return f16c;
+}
+
+bool hasAvx2() {
+    static const bool avx2 = [] {
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2");
+    }();
+    return avx2;
+}
+
+__attribute__((target("avx,f16c"))) size_t
+fp16ToFp32F16c(const uint16_t *src, float *dst, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+        _mm256_storeu_ps(dst + i, _mm256_cvtph_ps(_mm_loadu_si128(
+                                      reinterpret_cast<const __m128i *>(src + i))));
+    return i;
+}
+
+__attribute__((target("avx,f16c"))) size_t
+fp32ToFp16F16c(const float *src, uint16_t *dst, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i),
+                         _mm256_cvtps_ph(_mm256_loadu_ps(src + i),
+                                         _MM_FROUND_TO_NEAREST_INT));
+    return i;
+}
+
+__attribute__((target("avx2"))) size_t bf16ToFp32Avx2(const uint16_t *src,
+                                                      float *dst, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i h = _mm256_cvtepu16_epi32(
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i)));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i),
+                            _mm256_slli_epi32(h, 16));
+    }
+    return i;
+}
+
+__attribute__((target("avx2"))) size_t fp32ToBf16Avx2(const float *src,
+                                                      uint16_t *dst, size_t n) {
+    const __m256i bias = _mm256_set1_epi32(0x7fff);
+    const __m256i one = _mm256_set1_epi32(1);
+    const __m256i quiet = _mm256_set1_epi32(0x400000);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m256i packed[2];
+        for (int j = 0; j < 2; ++j) {
+            __m256 f = _mm256_loadu_ps(src + i + j * 8);
+            __m256i bits = _mm256_castps_si256(f);
+            // round to nearest even, nan kept quiet
+            __m256i odd = _mm256_and_si256(_mm256_srli_epi32(bits, 16), one);
+            __m256i rounded =
+                _mm256_add_epi32(bits, _mm256_add_epi32(bias, odd));
+            __m256i nan = _mm256_castps_si256(_mm256_cmp_ps(f, f, _CMP_UNORD_Q));
+            bits = _mm256_blendv_epi8(rounded, _mm256_or_si256(bits, quiet),
+                                      nan);
+            packed[j] = _mm256_srli_epi32(bits, 16);
+        }
+        // packus works within 128-bit lanes, so restore the element order
+        __m256i h = _mm256_permute4x64_epi64(
+            _mm256_packus_epi32(packed[0], packed[1]), 0xd8);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), h);
+    }
+    return i;
+}
+#endif
+
+} // namespace
+
+void fp16ToFp32(const uint16_t *src, float *dst, size_t n) {
+    size_t i = 0;
+#ifdef HALF_X86
+    if (hasF16c())
+        i = fp16ToFp32F16c(src, dst, n);
+#endif
+    for (; i < n; ++i)
+        dst[i] = fp16ToFp32(src[i]);
+}
+
+void fp32ToFp16(const float *src, uint16_t *dst, size_t n) {
+    size_t i = 0;
+#ifdef HALF_X86
+    if (hasF16c())
+        i = fp32ToFp16F16c(src, dst, n);
+#endif
+    for (; i < n; ++i)
+        dst[i] = fp32ToFp16(src[i]);
+}
+
+void bf16ToFp32(const uint16_t *src, float *dst, size_t n) {
+    size_t i = 0;
+#ifdef HALF_X86
+    if (hasAvx2())
+        i = bf16ToFp32Avx2(src, dst, n);
+#endif
+    for (; i < n; ++i)
+        dst[i] = bf16ToFp32(src[i]);
+}
+
+void fp32ToBf16(const float *src, uint16_t *dst, size_t n) {
+    size_t i = 0;
+#ifdef HALF_X86
+    if (hasAvx2())
+        i = fp32ToBf16Avx2(src, dst, n);
+#endif
+    for (; i < n; ++i)
+        dst[i] = fp32ToBf16(src[i]);
+}
+
+} // namespace infini
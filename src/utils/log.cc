@@ -0,0 +1,53 @@
+#include "utils/log.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+namespace infini {
+
+namespace {
+
+LogLevel initialLevel() {
+    const char *env = std::getenv("INFINI_LOG_LEVEL");
+    if (!env)
+        return LogLevel::Warning;
+    std::string name(env);
+    std::transform(name.begin(), name.end(), name.begin(),
+                   [](unsigned char c) { return std::tolower(c); });
+    if (name == "debug")
+        return LogLevel::Debug;
+    if (name == "info")
+        return LogLevel::Info;
+    if (name == "error")
+        return LogLevel::Error;
+    if (name == "off")
+        return LogLevel::Off;
+    return LogLevel::Warning;
+}
+
+} // namespace
+
+namespace detail {
+
+std::atomic<LogLevel> logLevel{initialLevel()};
+
+LogMessage::LogMessage(LogLevel level, const char *file, int line) {
+    static const char tags[] = {'D', 'I', 'W', 'E', 'O'};
+    const char *base = std::strrchr(file, '/');
+    os << '[' << tags[int(level)] << ' ' << (base ? base + 1 : file) << ':'
+       << line << "] ";
+}
+
+LogMessage::~LogMessage() {
+    os << '\n';
+    std::cerr << os.str();
+}
+
+} // namespace detail
+
+LogLevel getLogLevel() { return detail::logLevel.load(); }
+
+void setLogLevel(LogLevel level) { detail::logLevel.store(level); }
+
+} // namespace infini
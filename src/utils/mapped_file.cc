@@ -0,0 +1,35 @@
+#include "utils/mapped_file.h"
+#include "core/common.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace infini {
+
+MappedFile::MappedFile(const std::string &path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    IT_ASSERT(fd >= 0, "Cannot open " + path);
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        IT_ASSERT(false, "Cannot stat " + path);
+    }
+    bytes = st.st_size;
+    if (bytes > 0) {
+        void *ptr = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+                         fd, 0);
+        close(fd);
+        IT_ASSERT(ptr != MAP_FAILED, "Cannot map " + path);
+        addr = static_cast<char *>(ptr);
+    } else {
+        close(fd);
+    }
+}
+
+MappedFile::~MappedFile() {
+    if (addr)
+        munmap(addr, bytes);
+}
+
+} // namespace infini
@@ -1,5 +1,6 @@
 #include "utils/operator_utils.h"
 #include "core/runtime.h"
+#include "utils/log.h"
 
 namespace infini {
 
@@ -36,7 +37,8 @@ Shape infer_broadcast(const Shape &A, const Shape &B) {
             result.push_back(dimA);
         } else {
             // 无法广播时触发断言
-            printf("Broadcast failed at dimension %zu: A=%d B=%d\n", i, dimA, dimB);
+            IT_LOG(Error) << "Broadcast failed at dimension " << i
+                          << ": A=" << dimA << " B=" << dimB;
         }
     }
     return result;
@@ -79,6 +81,49 @@ size_t delocate_index(const Shape &shapeIndex, const Shape &shape,
     return ans;
 }
 
+BroadcastLayout collapse_broadcast(const vector<Shape> &inputs,
+                                   const Shape &output) {
+    auto rank = output.size();
+    auto n = inputs.size();
+    for (const auto &input : inputs)
+        IT_ASSERT(input.size() <= rank);
+    BroadcastLayout layout;
+    // Which inputs are broadcast along each collapsed dim
+    vector<vector<bool>> broadcast;
+    for (size_t i = 0; i < rank; ++i) {
+        if (output[i] == 1)
+            continue;
+        vector<bool> flags(n);
+        for (size_t j = 0; j < n; ++j) {
+            auto offset = rank - inputs[j].size();
+            flags[j] = i < offset || inputs[j][i - offset] == 1;
+        }
+        if (!broadcast.empty() && broadcast.back() == flags) {
+            layout.dims.back() *= output[i];
+        } else {
+            layout.dims.emplace_back(output[i]);
+            broadcast.emplace_back(std::move(flags));
+        }
+    }
+    if (layout.dims.empty()) {
+        // Scalar output
+        layout.dims = {1};
+        layout.strides.assign(n, {1});
+        return layout;
+    }
+    auto collapsed = layout.dims.size();
+    layout.strides.assign(n, vector<size_t>(collapsed));
+    for (size_t j = 0; j < n; ++j) {
+        size_t p = 1;
+        for (size_t i = collapsed; i > 0; --i) {
+            bool b = broadcast[i - 1][j];
+            layout.strides[j][i - 1] = b ? 0 : p;
+            p *= b ? 1 : layout.dims[i - 1];
+        }
+    }
+    return layout;
+}
+
 std::string device_to_str(Device device) {
     std::string deviceStr;
     switch (device) {
@@ -0,0 +1,86 @@
+#include "utils/quantize.h"
+#include <algorithm>
+#include <cmath>
+
+namespace infini {
+
+// Output column of element i of a matmul weight stored as [..., k, n], or as
+// [..., n, k] when transB is set.
+static size_t weightColumn(size_t i, const Shape &shape, bool transB) {
+    size_t rows = shape[shape.size() - 2], cols = shape.back();
+    return transB ? i / cols % rows : i % cols;
+}
+
+static size_t weightColumns(const Shape &shape, bool transB) {
+    IT_ASSERT(shape.size() >= 2);
+    return transB ? shape[shape.size() - 2] : shape.back();
+}
+
+QuantParams calibrateUInt8(const TensorVec &samples) {
+    float lo = 0.f, hi = 0.f;
+    for (const auto &sample : samples) {
+        IT_ASSERT(sample->getDType() == DataType::Float32);
+        auto ptr = sample->getRawDataPtr<float *>();
+        auto [min, max] = std::minmax_element(ptr, ptr + sample->size());
+        if (min != ptr + sample->size()) {
+            lo = std::min(lo, *min);
+            hi = std::max(hi, *max);
+        }
+    }
+    QuantParams params;
+    if (hi > lo) {
+        params.scale = (hi - lo) / 255.f;
+        params.zeroPoint = (int32_t)std::nearbyint(-lo / params.scale);
+    }
+    return params;
+}
+
+vector<float> calibrateInt8(const Tensor &weight, bool transB,
+                            bool perChannel) {
+    IT_ASSERT(weight->getDType() == DataType::Float32);
+    const auto &shape = weight->getDims();
+    vector<float> absMax(perChannel ? weightColumns(shape, transB) : 1, 0.f);
+    auto ptr = weight->getRawDataPtr<float *>();
+    for (size_t i = 0; i < weight->size(); ++i) {
+        auto &m = absMax[perChannel ? weightColumn(i, shape, transB) : 0];
+        m = std::max(m, std::abs(ptr[i]));
+    }
+    for (auto &m : absMax)
+        m = m > 0.f ? m / 127.f : 1.f;
+    return absMax;
+}
+
+void quantizeUInt8(const Tensor &src, const Tensor &dst, QuantParams params) {
+    IT_ASSERT(src->getDType() == DataType::Float32);
+    IT_ASSERT(dst->getDType() == DataType::UInt8);
+    IT_ASSERT(src->size() == dst->size());
+    auto in = src->getRawDataPtr<float *>();
+    auto out = dst->getRawDataPtr<uint8_t *>();
+    float invScale = 1.f / params.scale;
+#pragma omp parallel for
+    for (size_t i = 0; i < src->size(); ++i) {
+        float q = std::nearbyint(in[i] * invScale) + params.zeroPoint;
+        out[i] = (uint8_t)std::min(std::max(q, 0.f), 255.f);
+    }
+}
+
+void quantizeInt8(const Tensor &weight, const Tensor &dst,
+                  const vector<float> &scales, bool transB) {
+    IT_ASSERT(weight->getDType() == DataType::Float32);
+    IT_ASSERT(dst->getDType() == DataType::Int8);
+    IT_ASSERT(weight->size() == dst->size());
+    const auto &shape = weight->getDims();
+    IT_ASSERT(scales.size() == 1 ||
+              scales.size() == weightColumns(shape, transB));
+    auto in = weight->getRawDataPtr<float *>();
+    auto out = dst->getRawDataPtr<int8_t *>();
+#pragma omp parallel for
+    for (size_t i = 0; i < weight->size(); ++i) {
+        float scale =
+            scales[scales.size() == 1 ? 0 : weightColumn(i, shape, transB)];
+        float q = std::nearbyint(in[i] / scale);
+        out[i] = (int8_t)std::min(std::max(q, -127.f), 127.f);
+    }
+}
+
+} // namespace infini
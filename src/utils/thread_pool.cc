@@ -0,0 +1,92 @@
+#include "utils/thread_pool.h"
+#include "core/common.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace infini {
+
+// Pool and index of the worker running on this thread, if any.
+static thread_local const ThreadPool *workerPool = nullptr;
+static thread_local int workerIndex = -1;
+
+ThreadPool::ThreadPool(int numWorkers, int intraOpThreads)
+    : intraOpThreads(intraOpThreads) {
+    IT_ASSERT(numWorkers > 0 && intraOpThreads > 0);
+    for (int i = 0; i < numWorkers; ++i)
+        queues.emplace_back(std::make_unique<Queue>());
+    for (int i = 0; i < numWorkers; ++i)
+        workers.emplace_back([this, i]() { workerLoop(i); });
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stop = true;
+    }
+    wakeUp.notify_all();
+    for (auto &worker : workers)
+        worker.join();
+}
+
+void ThreadPool::submit(Task task) {
+    size_t index = workerPool == this ? workerIndex
+                                      : nextQueue++ % queues.size();
+    {
+        // Count the task before it becomes visible so that the counter never
+        // drops below zero, and do it under the sleep lock so a worker cannot
+        // miss it between checking the counter and going to sleep.
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        ++queued;
+    }
+    {
+        std::lock_guard<std::mutex> lock(queues[index]->mutex);
+        queues[index]->tasks.emplace_back(std::move(task));
+    }
+    wakeUp.notify_one();
+}
+
+bool ThreadPool::tryPop(int index, Task &task) {
+    {
+        auto &own = *queues[index];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            return true;
+        }
+    }
+    for (size_t i = 1; i < queues.size(); ++i) {
+        auto &victim = *queues[(index + i) % queues.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::workerLoop(int index) {
+    workerPool = this;
+    workerIndex = index;
+#ifdef _OPENMP
+    omp_set_num_threads(intraOpThreads);
+#endif
+    Task task;
+    while (true) {
+        if (tryPop(index, task)) {
+            --queued;
+            task();
+            task = nullptr;
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        wakeUp.wait(lock, [this]() { return stop || queued > 0; });
+        if (stop && queued == 0)
+            return;
+    }
+}
+
+} // namespace infini
@@ -71,4 +71,108 @@ namespace infini
         EXPECT_EQ(ptr1, ptr2);
     }
 
+    TEST(Allocator, testPlanGreedyBySize)
+    {
+        Shape shape = Shape{1, 2, 2, 3};
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        Tensor a = make_ref<TensorObj>(shape, DataType::Float32, runtime);
+        Tensor b = make_ref<TensorObj>(shape, DataType::Float32, runtime);
+        Tensor c =
+            make_ref<TensorObj>(Shape{2, 2, 2, 3}, DataType::Float32, runtime);
+        // a dies before c is born, but the hole it leaves is too small for c
+        vector<MemoryInterval> intervals = {{a->getBytes(), 0, 0},
+                                            {b->getBytes(), 0, 2},
+                                            {c->getBytes(), 1, 2}};
+        Allocator firstFit = Allocator(runtime);
+        firstFit.plan(intervals);
+        Allocator greedy = Allocator(runtime);
+        greedy.setStrategy(MemoryPlanStrategy::GreedyBySize);
+        auto offsets = greedy.plan(intervals);
+        greedy.info();
+        // expected to be c->b, with a placed in c's slot before c is born
+        EXPECT_EQ(offsets[2], 0);
+        EXPECT_EQ(offsets[0], 0);
+        EXPECT_EQ(greedy.getPeak(), b->getBytes() + c->getBytes());
+        EXPECT_EQ(greedy.getPeak(), greedy.getLowerBound());
+        EXPECT_LT(greedy.getPeak(), firstFit.getPeak());
+    }
+
+    TEST(Allocator, testPlanNoOverlap)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        vector<MemoryInterval> intervals;
+        for (size_t i = 0; i < 64; ++i)
+        {
+            size_t begin = i * 7 % 23;
+            intervals.push_back({(i * 37 % 11 + 1) * 24, begin,
+                                 begin + i * 5 % 9});
+        }
+        for (auto strategy :
+             {MemoryPlanStrategy::FirstFit, MemoryPlanStrategy::BestFit,
+              MemoryPlanStrategy::GreedyBySize})
+        {
+            Allocator allocator = Allocator(runtime);
+            allocator.setStrategy(strategy);
+            auto offsets = allocator.plan(intervals);
+            EXPECT_GE(allocator.getPeak(), allocator.getLowerBound());
+            // blocks alive at the same time must not share memory
+            for (size_t i = 0; i < intervals.size(); ++i)
+            {
+                EXPECT_LE(offsets[i] + intervals[i].size, allocator.getPeak());
+                for (size_t j = i + 1; j < intervals.size(); ++j)
+                {
+                    if (intervals[i].end < intervals[j].begin ||
+                        intervals[j].end < intervals[i].begin)
+                        continue;
+                    EXPECT_TRUE(offsets[i] + intervals[i].size <= offsets[j] ||
+                                offsets[j] + intervals[j].size <= offsets[i]);
+                }
+            }
+        }
+    }
+
+    TEST(Allocator, testStats)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        Allocator allocator = Allocator(runtime);
+        // 3 and 13 bytes are padded to 8 and 16
+        auto offsets = allocator.plan({{3, 0, 1, 11}, {13, 1, 2, 12},
+                                       {8, 2, 2, 13}});
+        auto stats = allocator.getStats();
+        EXPECT_EQ(stats.requested, 24u);
+        EXPECT_EQ(stats.padding, 8u);
+        EXPECT_EQ(stats.peak, allocator.getPeak());
+        EXPECT_EQ(stats.lowerBound, 24u);
+        ASSERT_EQ(stats.blocks.size(), 3u);
+        for (size_t i = 0; i < 3; ++i)
+        {
+            EXPECT_EQ(stats.blocks[i].tensor, UidBaseType(11 + i));
+            EXPECT_EQ(stats.blocks[i].offset, offsets[i]);
+        }
+        EXPECT_EQ(stats.blocks[1].size, 16u);
+        EXPECT_EQ(stats.blocks[1].requested, 13u);
+        EXPECT_GE(stats.fragmentation, 0.);
+        EXPECT_LT(stats.fragmentation, 1.);
+
+        std::ostringstream timeline, layout;
+        allocator.writeTimeline(timeline);
+        EXPECT_NE(timeline.str().find("\"tensor\": 12, \"offset\": " +
+                                      std::to_string(offsets[1])),
+                  string::npos);
+        allocator.printLayout(layout, 8);
+        // a header and one row per step
+        string rows = layout.str();
+        EXPECT_EQ(std::count(rows.begin(), rows.end(), '\n'), 4);
+
+        // planning again replaces the statistics instead of adding to them
+        allocator.plan({{5, 0, 0, 21}});
+        stats = allocator.getStats();
+        EXPECT_EQ(stats.requested, 5u);
+        EXPECT_EQ(stats.padding, 3u);
+        EXPECT_EQ(stats.lowerBound, 8u);
+        EXPECT_EQ(stats.peak, 8u);
+        ASSERT_EQ(stats.blocks.size(), 1u);
+        EXPECT_EQ(stats.blocks[0].tensor, UidBaseType(21));
+    }
+
 } // namespace infini
@@ -1,10 +1,14 @@
 #include "core/graph.h"
 #include "core/kernel.h"
 #include "core/runtime.h"
+#include "operators/element_wise.h"
+#include "operators/fused_element_wise.h"
 #include "operators/matmul.h"
 #include "operators/transpose.h"
+#include "operators/unary.h"
 
 #include "test.h"
+#include <numeric>
 
 namespace infini
 {
@@ -37,4 +41,442 @@ namespace infini
         EXPECT_EQ(op->getTransA(), false);
         EXPECT_EQ(op->getTransB(), true);
     }
-}
\ No newline at end of file
+
+    TEST(Graph, DataMallocReuse)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        Graph g = make_ref<GraphObj>(runtime);
+        Tensor i = g->addTensor({2, 3, 4}, DataType::Float32);
+        auto r1 = g->addOp<ReluObj>(i, nullptr);
+        auto r2 = g->addOp<ReluObj>(r1->getOutput(), nullptr);
+        auto r3 = g->addOp<ReluObj>(r2->getOutput(), nullptr);
+        auto r4 = g->addOp<ReluObj>(r3->getOutput(), nullptr);
+        g->dataMalloc();
+        // the graph input is never overwritten
+        for (auto &op : {r1, r2, r3, r4})
+            EXPECT_NE(op->getOutput()->getRawDataPtr<void *>(),
+                      i->getRawDataPtr<void *>());
+        // r2 to r4 run in place: each input is dead once its op has run
+        for (auto &op : {r2, r3, r4})
+            EXPECT_EQ(op->getOutput()->getRawDataPtr<void *>(),
+                      op->getInputs(0)->getRawDataPtr<void *>());
+        i->setData(IncrementalGenerator());
+        runtime->run(g);
+        EXPECT_TRUE(r4->getOutput()->equalData(i));
+    }
+    TEST(Graph, InPlaceElementWise)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        Graph g = make_ref<GraphObj>(runtime);
+        Tensor i = g->addTensor({4, 64}, DataType::Float32);
+        Tensor bias = g->addTensor({64}, DataType::Float32);
+        auto relu = g->addOp<ReluObj>(i, nullptr);
+        auto add = g->addOp<AddObj>(bias, relu->getOutput(), nullptr);
+        auto sq = g->addOp<MulObj>(add->getOutput(), add->getOutput(), nullptr);
+        auto clip = g->addOp<ClipObj>(sq->getOutput(), nullptr, 0.f, 1000.f);
+        // add's output is read by an op that runs later, so sq cannot reuse
+        // it; sub still can, as add's output dies with it
+        auto sub = g->addOp<SubObj>(clip->getOutput(), add->getOutput(),
+                                    nullptr);
+        g->dataMalloc();
+        auto ptr = [](const Operator &op)
+        { return op->getOutput()->getRawDataPtr<void *>(); };
+        EXPECT_EQ(ptr(add), ptr(relu));
+        EXPECT_NE(ptr(sq), ptr(add));
+        EXPECT_EQ(ptr(clip), ptr(sq));
+        EXPECT_EQ(ptr(sub), ptr(clip));
+        // input, bias and two live activations
+        EXPECT_EQ(g->getAllocator().getStats().peak,
+                  3 * i->getBytes() + bias->getBytes());
+
+        i->setData(IncrementalGenerator());
+        bias->setData(ValGenerator<-100>());
+        runtime->run(g);
+        vector<float> expected(i->size());
+        for (size_t k = 0; k < expected.size(); ++k)
+        {
+            float a = float(k) - 100;
+            expected[k] = std::min(std::max(a * a, 0.f), 1000.f) - a;
+        }
+        EXPECT_TRUE(sub->getOutput()->equalData(expected));
+    }
+    TEST(Graph, DynamicShapes)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        Graph g = make_ref<GraphObj>(runtime);
+        Tensor x = g->addTensor({2, 8}, DataType::Float32);
+        Tensor w = g->addTensor({8, 4}, DataType::Float32);
+        Tensor bias = g->addTensor({4}, DataType::Float32);
+        w->setConstant();
+        w->setData(IncrementalGenerator());
+        bias->setConstant();
+        bias->setData(ValGenerator<-300>());
+        auto matmul = g->addOp<MatmulObj>(x, w, nullptr);
+        auto add = g->addOp<AddObj>(matmul->getOutput(), bias, nullptr);
+        auto relu = g->addOp<ReluObj>(add->getOutput(), nullptr);
+        auto y = relu->getOutput();
+        EXPECT_EQ(g->getInputs(), TensorVec{x});
+
+        auto feed = [&](int batch)
+        {
+            x->setData(IncrementalGenerator());
+            vector<float> expected;
+            for (int i = 0; i < batch; ++i)
+                for (int j = 0; j < 4; ++j)
+                {
+                    float sum = -300;
+                    for (int p = 0; p < 8; ++p)
+                        sum += float(i * 8 + p) * float(p * 4 + j);
+                    expected.emplace_back(std::max(sum, 0.f));
+                }
+            return expected;
+        };
+        g->dataMalloc();
+        auto small = runtime->compile(g);
+        auto expected = feed(2);
+        runtime->run(small);
+        EXPECT_TRUE(y->equalData(expected));
+        auto smallX = x->getRawDataPtr<void *>();
+        auto smallAllocator = &g->getAllocator();
+
+        g->setInputShapes({{5, 8}});
+        EXPECT_EQ(y->getDims(), (Shape{5, 4}));
+        EXPECT_NE(&g->getAllocator(), smallAllocator);
+        auto large = runtime->compile(g);
+        expected = feed(5);
+        runtime->run(large);
+        EXPECT_TRUE(y->equalData(expected));
+
+        // back to a batch seen before: the cached plan and its memory are
+        // reused, and so is the execution plan compiled for it
+        g->setInputShapes({{2, 8}});
+        EXPECT_EQ(&g->getAllocator(), smallAllocator);
+        EXPECT_EQ(x->getRawDataPtr<void *>(), smallX);
+        expected = feed(2);
+        runtime->run(small);
+        EXPECT_TRUE(y->equalData(expected));
+    }
+    TEST(Graph, DynamicShapesOutOfOrder)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        Graph g = make_ref<GraphObj>(runtime);
+        Tensor x = g->addTensor({2, 8}, DataType::Float32);
+        Tensor t = g->addTensor({2, 8}, DataType::Float32);
+        Tensor y = g->addTensor({2, 8}, DataType::Float32);
+        // the consumer is added before its producer
+        g->addOpWithOutputs<ReluObj>(t, y);
+        g->addOpWithOutputs<ReluObj>(x, t);
+        EXPECT_EQ(g->getInputs(), TensorVec{x});
+
+        g->setInputShapes({{5, 8}});
+        EXPECT_EQ(t->getDims(), (Shape{5, 8}));
+        EXPECT_EQ(y->getDims(), (Shape{5, 8}));
+        x->setData(IncrementalGenerator());
+        runtime->run(g);
+        vector<float> expected(40);
+        std::iota(expected.begin(), expected.end(), 0.f);
+        EXPECT_TRUE(y->equalData(expected));
+    }
+    TEST(Graph, MemoryPlanEviction)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        Graph g = make_ref<GraphObj>(runtime);
+        Tensor x = g->addTensor({1, 8}, DataType::Float32);
+        auto relu = g->addOp<ReluObj>(x, nullptr);
+        auto y = relu->getOutput();
+
+        std::map<int, std::weak_ptr<const Allocator>> arenas;
+        ExecutionPlan second;
+        for (int batch = 1; batch <= 4; ++batch)
+        {
+            g->setInputShapes({{batch, 8}});
+            arenas[batch] = g->shareAllocator();
+            if (batch == 2)
+                second = runtime->compile(g);
+        }
+        // four plans fit in the cache: going back to batch 1 reuses its arena
+        g->setInputShapes({{1, 8}});
+        EXPECT_EQ(g->shareAllocator(), arenas[1].lock());
+
+        // a fifth shape evicts the least recently used plan (batch 2), but
+        // the execution plan compiled for it keeps its arena alive
+        g->setInputShapes({{5, 8}});
+        EXPECT_FALSE(arenas[2].expired());
+        g->setInputShapes({{6, 8}});
+        EXPECT_TRUE(arenas[3].expired());
+        EXPECT_FALSE(arenas[1].expired());
+        EXPECT_FALSE(arenas[4].expired());
+        second = ExecutionPlan();
+        EXPECT_TRUE(arenas[2].expired());
+
+        // an evicted shape is planned again in a new arena
+        g->setInputShapes({{3, 8}});
+        x->setData(IncrementalGenerator());
+        runtime->run(g);
+        vector<float> expected(24);
+        std::iota(expected.begin(), expected.end(), 0.f);
+        EXPECT_TRUE(y->equalData(expected));
+        EXPECT_TRUE(arenas[4].expired());
+    }
+    TEST(Graph, FuseElementWise)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        auto build = [&](Graph g)
+        {
+            Tensor x = g->addTensor({2, 3, 40}, DataType::Float32);
+            Tensor bias = g->addTensor({40}, DataType::Float32);
+            Tensor scale = g->addTensor({3, 1}, DataType::Float32);
+            auto add = g->addOp<AddObj>(x, bias, nullptr);
+            auto relu = g->addOp<ReluObj>(add->getOutput(), nullptr);
+            auto mul = g->addOp<MulObj>(relu->getOutput(), scale, nullptr);
+            auto clip = g->addOp<ClipObj>(mul->getOutput(), nullptr, 2.f, 50.f);
+            auto sq = g->addOp<MulObj>(clip->getOutput(), clip->getOutput(),
+                                       nullptr);
+            // relu's output is read twice within the chain
+            auto sub = g->addOp<SubObj>(sq->getOutput(), relu->getOutput(),
+                                        nullptr);
+            // add's output has a consumer outside the chain, so it stays
+            auto transpose = g->addOp<TransposeObj>(add->getOutput(), nullptr,
+                                                    Shape{0, 2, 1});
+            return vector<Tensor>{x, bias, scale, sub->getOutput(),
+                                  transpose->getOutput()};
+        };
+        Graph ref = make_ref<GraphObj>(runtime);
+        Graph g = make_ref<GraphObj>(runtime);
+        auto refTensors = build(ref);
+        auto tensors = build(g);
+        g->optimize();
+        // add, transpose and relu+mul+clip+mul+sub
+        EXPECT_EQ(g->getOperators().size(), 3);
+        EXPECT_EQ(g->getTensors().size(), 6);
+        auto fused = tensors[3]->getSource();
+        EXPECT_EQ(fused->getOpType(), OpType::FusedElementWise);
+        EXPECT_EQ(as<FusedElementWiseObj>(fused)->getSteps().size(), 5);
+        EXPECT_EQ(fused->getInputs().size(), 2);
+        EXPECT_TRUE(g->checkValid());
+
+        for (auto graph : {ref, g})
+            graph->dataMalloc();
+        for (auto &ts : {refTensors, tensors})
+        {
+            ts[0]->setData(IncrementalGenerator());
+            ts[1]->setData(ValGenerator<-30>());
+            ts[2]->setData(IncrementalGenerator());
+        }
+        runtime->run(ref);
+        runtime->run(g);
+        EXPECT_TRUE(tensors[3]->equalData(refTensors[3]));
+        EXPECT_TRUE(tensors[4]->equalData(refTensors[4]));
+    }
+    TEST(Graph, CanonicalizeTransposes)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        auto build = [&](Graph g)
+        {
+            Tensor x = g->addTensor({2, 4, 3}, DataType::Float32);
+            Tensor w = g->addTensor({4, 5}, DataType::Float32);
+            Tensor a = g->addTensor({3, 6}, DataType::Float32);
+            Tensor b = g->addTensor({3, 6}, DataType::Float32);
+            // the first two compose to the identity, the third is absorbed
+            // by the matmul once it has sunk below the relu
+            auto t1 = g->addOp<TransposeObj>(x, nullptr, Shape{1, 2, 0});
+            auto t2 = g->addOp<TransposeObj>(t1->getOutput(), nullptr,
+                                             Shape{2, 0, 1});
+            auto t3 = g->addOp<TransposeObj>(t2->getOutput(), nullptr,
+                                             Shape{0, 2, 1});
+            auto relu = g->addOp<ReluObj>(t3->getOutput(), nullptr);
+            auto matmul = g->addOp<MatmulObj>(relu->getOutput(), w, nullptr);
+            // both operands transposed alike: one transpose of the sum
+            auto ta = g->addOp<TransposeObj>(a, nullptr, Shape{1, 0});
+            auto tb = g->addOp<TransposeObj>(b, nullptr, Shape{1, 0});
+            auto add = g->addOp<AddObj>(ta->getOutput(), tb->getOutput(),
+                                        nullptr);
+            auto identity = g->addOp<TransposeObj>(add->getOutput(), nullptr,
+                                                   Shape{0, 1});
+            auto clip =
+                g->addOp<ClipObj>(identity->getOutput(), nullptr, 0.f, 20.f);
+            return vector<Tensor>{x, w, a, b, matmul->getOutput(),
+                                  clip->getOutput()};
+        };
+        Graph ref = make_ref<GraphObj>(runtime);
+        Graph g = make_ref<GraphObj>(runtime);
+        auto refTensors = build(ref);
+        auto tensors = build(g);
+        g->optimize();
+        EXPECT_TRUE(g->checkValid());
+        int transposes = 0;
+        for (auto &op : g->getOperators())
+            transposes += op->getOpType() == OpType::Transpose;
+        EXPECT_EQ(transposes, 1);
+        auto matmul = as<MatmulObj>(tensors[4]->getSource());
+        EXPECT_TRUE(matmul->getTransA());
+        EXPECT_EQ(matmul->getInputs(0)->getSource()->getOpType(),
+                  OpType::Relu);
+        EXPECT_EQ(matmul->getInputs(0)->getSource()->getInputs(0), tensors[0]);
+
+        for (auto graph : {ref, g})
+            graph->dataMalloc();
+        for (auto &ts : {refTensors, tensors})
+        {
+            ts[0]->setData(IncrementalGenerator());
+            ts[1]->setData(ValGenerator<-1>());
+            ts[2]->setData(IncrementalGenerator());
+            ts[3]->setData(ValGenerator<-5>());
+        }
+        runtime->run(ref);
+        runtime->run(g);
+        EXPECT_TRUE(tensors[4]->equalData(refTensors[4]));
+        EXPECT_TRUE(tensors[5]->equalData(refTensors[5]));
+    }
+    TEST(Graph, FoldConstants)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        auto build = [&](Graph g)
+        {
+            Tensor x = g->addTensor({2, 3}, DataType::Float32);
+            Tensor w = g->addTensor({4, 3}, DataType::Float32);
+            auto transpose = g->addOp<TransposeObj>(w, nullptr, Shape{1, 0});
+            auto relu = g->addOp<ReluObj>(transpose->getOutput(), nullptr);
+            auto matmul = g->addOp<MatmulObj>(x, relu->getOutput(), nullptr);
+            return vector<Tensor>{x, w, matmul->getOutput()};
+        };
+        auto weights = [](void *data, size_t size, DataType)
+        {
+            auto ptr = static_cast<float *>(data);
+            for (size_t i = 0; i < size; ++i)
+                ptr[i] = float(int(i * 7 % 11) - 5);
+        };
+        Graph ref = make_ref<GraphObj>(runtime);
+        Graph g = make_ref<GraphObj>(runtime);
+        auto refTensors = build(ref);
+        auto tensors = build(g);
+        tensors[1]->setConstant();
+        tensors[1]->setData(weights);
+        g->optimize();
+        // transpose and relu are computed once, the weight is not needed
+        EXPECT_EQ(g->getOperators().size(), 1);
+        EXPECT_FALSE(g->hasTensor(tensors[1]));
+        auto b = g->getOperators()[0]->getInputs(1);
+        EXPECT_TRUE(b->isConstant());
+        EXPECT_FALSE(b->getSource());
+        EXPECT_EQ(g->getInputs(), TensorVec{tensors[0]});
+        EXPECT_TRUE(g->checkValid());
+
+        ref->dataMalloc();
+        g->dataMalloc();
+        refTensors[1]->setData(weights);
+        for (auto &ts : {refTensors, tensors})
+            ts[0]->setData(IncrementalGenerator());
+        runtime->run(ref);
+        runtime->run(runtime->compile(g));
+        EXPECT_TRUE(tensors[2]->equalData(refTensors[2]));
+    }
+    TEST(Graph, FoldConstantsIntoOutput)
+    {
+        // a constant subgraph that ends in a graph output keeps its last
+        // operator, so the output still has a source
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        Graph g = make_ref<GraphObj>(runtime);
+        Tensor w = g->addTensor({2, 3}, DataType::Float32);
+        auto transpose = g->addOp<TransposeObj>(w, nullptr, Shape{1, 0});
+        auto relu = g->addOp<ReluObj>(transpose->getOutput(), nullptr);
+        auto y = relu->getOutput();
+        w->setConstant();
+        w->setData(IncrementalGenerator());
+        g->optimize();
+        EXPECT_EQ(g->getOperators(), OpVec{relu});
+        EXPECT_EQ(g->getOutputs(), TensorVec{y});
+        EXPECT_EQ(y->getSource(), relu);
+        EXPECT_TRUE(g->checkValid());
+
+        g->dataMalloc();
+        runtime->run(g);
+        EXPECT_TRUE(y->equalData(vector<float>{0, 3, 1, 4, 2, 5}));
+    }
+    TEST(Graph, FuseMatmulEpilogue)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        auto build = [&](Graph g)
+        {
+            Tensor a = g->addTensor({2, 5, 7}, DataType::Float32);
+            Tensor b = g->addTensor({7, 3}, DataType::Float32);
+            Tensor bias = g->addTensor({3}, DataType::Float32);
+            auto matmul = g->addOp<MatmulObj>(a, b, nullptr);
+            auto add = g->addOp<AddObj>(bias, matmul->getOutput(), nullptr);
+            auto relu = g->addOp<ReluObj>(add->getOutput(), nullptr);
+            auto clip = g->addOp<ClipObj>(relu->getOutput(), nullptr,
+                                          std::nullopt, 300.f);
+            return vector<Tensor>{a, b, bias, clip->getOutput()};
+        };
+        Graph ref = make_ref<GraphObj>(runtime);
+        Graph g = make_ref<GraphObj>(runtime);
+        auto refTensors = build(ref);
+        auto tensors = build(g);
+        g->optimize();
+        EXPECT_EQ(g->getOperators().size(), 1);
+        EXPECT_EQ(g->getTensors().size(), 4);
+        EXPECT_TRUE(g->checkValid());
+        auto matmul = as<MatmulObj>(g->getOperators()[0]);
+        EXPECT_EQ(matmul->getBias(), tensors[2]);
+        EXPECT_EQ(matmul->getMin(), 0.f);
+        EXPECT_EQ(matmul->getMax(), 300.f);
+        EXPECT_EQ(matmul->getOutput(), tensors[3]);
+
+        for (auto graph : {ref, g})
+            graph->dataMalloc();
+        for (auto &ts : {refTensors, tensors})
+        {
+            ts[0]->setData(IncrementalGenerator());
+            ts[1]->setData(IncrementalGenerator());
+            ts[2]->setData(ValGenerator<-500>());
+        }
+        runtime->run(ref);
+        runtime->run(g);
+        EXPECT_TRUE(tensors[3]->equalData(refTensors[3]));
+    }
+
+    TEST(Graph, LargeGraphEdits)
+    {
+        // A long chain added consumer first, so that sorting must reverse it
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        Graph g = make_ref<GraphObj>(runtime);
+        const int n = 20000;
+        TensorVec chain;
+        for (int i = 0; i <= n; ++i)
+            chain.emplace_back(g->addTensor({4}, DataType::Float32));
+        for (int i = n - 1; i >= 0; --i)
+            g->addOpWithOutputs<ReluObj>(chain[i], chain[i + 1]);
+        ASSERT_TRUE(g->topo_sort());
+        const auto &ops = g->getOperators();
+        for (int i = 0; i < n; ++i)
+            ASSERT_EQ(ops[i]->getOutput(), chain[i + 1]);
+
+        // Removing every other operator keeps the order of the rest
+        for (int i = 0; i < n; i += 2)
+            g->removeOperator(chain[i + 1]->getSource());
+        g->compact();
+        EXPECT_EQ(g->getOperators().size(), size_t(n / 2));
+        for (int i = 0; i < n / 2; ++i)
+            ASSERT_EQ(g->getOperators()[i]->getOutput(), chain[2 * i + 2]);
+
+        EXPECT_EQ(g->getTensor(chain[7]->getFuid()), chain[7]);
+        g->removeTensor(chain[7]);
+        EXPECT_FALSE(g->hasTensor(chain[7]));
+        EXPECT_EQ(g->getTensor(chain[7]->getFuid()), nullptr);
+        EXPECT_THROW(g->getTensors(), Exception);
+        g->compact();
+        EXPECT_EQ(g->getTensors().size(), size_t(n));
+        EXPECT_EQ(g->getTensors()[7], chain[8]);
+    }
+
+    TEST(Graph, TopoSortCycle)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        Graph g = make_ref<GraphObj>(runtime);
+        auto a = g->addTensor({4}, DataType::Float32);
+        auto b = g->addTensor({4}, DataType::Float32);
+        g->addOpWithOutputs<ReluObj>(a, b);
+        g->addOpWithOutputs<ReluObj>(b, a);
+        EXPECT_FALSE(g->topo_sort());
+    }
+}
@@ -0,0 +1,95 @@
+#include "core/graph.h"
+#include "core/runtime.h"
+#include "operators/concat.h"
+#include "operators/element_wise.h"
+#include "operators/fused_element_wise.h"
+#include "operators/matmul.h"
+#include "operators/transpose.h"
+#include "operators/unary.h"
+
+#include "test.h"
+
+#ifdef USE_JSON
+#include "core/graph_json.h"
+
+namespace infini
+{
+    TEST(GraphJson, RoundTrip)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        Graph g = make_ref<GraphObj>(runtime);
+        auto x = g->addTensor({2, 8}, DataType::Float32);
+        auto w = g->addTensor({8, 6}, DataType::Float32);
+        auto bias = g->addTensor({6}, DataType::Float32);
+        auto mm = g->addOp<MatmulObj>(x, w, nullptr)->getOutput();
+        auto a = g->addOp<AddObj>(mm, bias, nullptr)->getOutput();
+        auto r = g->addOp<ReluObj>(a, nullptr)->getOutput();
+        auto t = g->addOp<TransposeObj>(r, nullptr, vector<int>{1, 0})
+                     ->getOutput();
+        auto c = g->addOp<ConcatObj>(TensorVec{t, t}, nullptr, 1)->getOutput();
+        auto d = g->addOp<MulObj>(c, c, nullptr)->getOutput();
+        auto e = g->addOp<ClipObj>(d, nullptr, std::nullopt, 9.f)->getOutput();
+        g->addOp<CastObj>(e, nullptr, CastType::Float2Float16);
+        g->optimize();
+
+        auto text = graphToJson(g, {{w, "fc.weight"}, {bias, "fc.bias"}});
+        // Cast types are written by name
+        EXPECT_NE(text.find("\"Float2Float16\""), string::npos);
+        std::unordered_map<string, Tensor> weights;
+        Graph loaded = graphFromJson(runtime, text, &weights);
+        // Exporting again gives the same document
+        std::unordered_map<Tensor, string> names;
+        for (const auto &[name, tensor] : weights)
+            names[tensor] = name;
+        EXPECT_EQ(graphToJson(loaded, names), text);
+
+        ASSERT_EQ(weights.size(), 2u);
+        EXPECT_EQ(weights["fc.weight"]->getDims(), (Shape{8, 6}));
+        const auto &ops = loaded->getOperators();
+        ASSERT_EQ(ops.size(), g->getOperators().size());
+        auto matmul = as<MatmulObj>(ops[0]);
+        ASSERT_TRUE(matmul);
+        EXPECT_EQ(matmul->getBias(), weights["fc.bias"]);
+        EXPECT_EQ(matmul->getMin(), 0.f);
+        auto fused = as<FusedElementWiseObj>(ops[3]);
+        ASSERT_TRUE(fused);
+        EXPECT_EQ(fused->getSteps().back().max, 9.f);
+        EXPECT_EQ(loaded->getOutputs()[0]->getDType(), DataType::Float16);
+    }
+
+    TEST(GraphJson, HandEdited)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        auto g = graphFromJson(runtime, R"({
+            "tensors": [
+                {"id": 10, "dims": [2, 3], "dtype": "Float32"},
+                {"id": 11, "dims": [3], "dtype": "Float32", "weight": "b"},
+                {"id": 12, "dims": [2, 3], "dtype": "Float32"}
+            ],
+            "ops": [{"type": "Sub", "inputs": [10, 11], "outputs": [12]}]
+        })");
+        g->dataMalloc();
+        auto tensors = g->getTensors();
+        tensors[0]->setData(IncrementalGenerator());
+        tensors[1]->setData(OneGenerator());
+        runtime->run(g);
+        EXPECT_TRUE(tensors[2]->equalData(vector<float>{-1, 0, 1, 2, 3, 4}));
+
+        EXPECT_THROW(graphFromJson(runtime, "{"), Exception);
+        EXPECT_THROW(graphFromJson(runtime, R"({"tensors": [], "ops": [
+            {"type": "Gemm", "inputs": [], "outputs": [0]}]})"),
+                     Exception);
+        EXPECT_THROW(graphFromJson(runtime, R"({
+            "tensors": [{"id": 0, "dims": [2], "dtype": "Float32"},
+                        {"id": 1, "dims": [3], "dtype": "Float32"}],
+            "ops": [{"type": "Relu", "inputs": [0], "outputs": [1]}]})"),
+                     Exception);
+        EXPECT_THROW(graphFromJson(runtime, R"({
+            "tensors": [{"id": 0, "dims": [2], "dtype": "Float32"},
+                        {"id": 1, "dims": [2], "dtype": "Float16"}],
+            "ops": [{"type": "Cast", "inputs": [0], "outputs": [1],
+                     "attrs": {"castType": 0}}]})"),
+                     Exception);
+    }
+} // namespace infini
+#endif
@@ -0,0 +1,206 @@
+#include "core/graph.h"
+#include "core/onnx.h"
+#include "core/runtime.h"
+#include "utils/half.h"
+
+#include "test.h"
+#include <cstdio>
+#include <fstream>
+
+namespace infini
+{
+    namespace
+    {
+        // Just enough of a protobuf writer to build ONNX models in tests
+        struct Proto
+        {
+            string buf;
+
+            void varint(uint64_t val)
+            {
+                for (; val >= 0x80; val >>= 7)
+                    buf += char(val | 0x80);
+                buf += char(val);
+            }
+            Proto &i(uint32_t field, int64_t val)
+            {
+                varint(field << 3);
+                varint(val);
+                return *this;
+            }
+            Proto &f(uint32_t field, float val)
+            {
+                varint(field << 3 | 5);
+                buf.append(reinterpret_cast<const char *>(&val), sizeof(val));
+                return *this;
+            }
+            Proto &s(uint32_t field, const string &val)
+            {
+                varint(field << 3 | 2);
+                varint(val.size());
+                buf += val;
+                return *this;
+            }
+            Proto &m(uint32_t field, const Proto &val)
+            {
+                return s(field, val.buf);
+            }
+        };
+
+        Proto node(const string &type, vector<string> inputs,
+                   vector<string> outputs, vector<Proto> attrs = {})
+        {
+            Proto p;
+            for (auto &in : inputs)
+                p.s(1, in);
+            for (auto &out : outputs)
+                p.s(2, out);
+            p.s(4, type);
+            for (auto &attr : attrs)
+                p.m(5, attr);
+            return p;
+        }
+
+        Proto intAttr(const string &name, int64_t val)
+        {
+            return Proto().s(1, name).i(3, val);
+        }
+
+        Proto floatTensor(const string &name, Shape dims,
+                          const vector<float> &data, bool raw)
+        {
+            Proto p;
+            for (auto d : dims)
+                p.i(1, d);
+            p.i(2, 1).s(8, name);
+            if (raw)
+                p.s(9, string(reinterpret_cast<const char *>(data.data()),
+                              data.size() * sizeof(float)));
+            else
+                for (auto v : data)
+                    p.f(4, v);
+            return p;
+        }
+
+        Proto input(const string &name, int type,
+                    vector<std::variant<int, string>> dims)
+        {
+            Proto shape;
+            for (auto &d : dims)
+            {
+                Proto dim;
+                if (auto v = std::get_if<int>(&d))
+                    dim.i(1, *v);
+                else
+                    dim.s(2, std::get<string>(d));
+                shape.m(1, dim);
+            }
+            Proto tensor = Proto().i(1, type).m(2, shape);
+            return Proto().s(1, name).m(2, Proto().m(1, tensor));
+        }
+
+        string writeModel(const string &file, const Proto &graph)
+        {
+            string path = ::testing::TempDir() + file;
+            std::ofstream out(path, std::ios::binary);
+            out << Proto().i(1, 8).m(7, graph).buf;
+            return path;
+        }
+    } // namespace
+
+    TEST(Onnx, Import)
+    {
+        // y = Cast(Transpose(Clip(Relu(Gemm(x, w^T, b)), 1, 20)), fp16)
+        // w is raw data in an external file, b typed float data, the Clip
+        // bounds a Constant node and an initializer.
+        vector<float> w(3 * 4), b{-20, 0, 5};
+        for (size_t i = 0; i < w.size(); ++i)
+            w[i] = float(i % 5);
+        string weights = ::testing::TempDir() + "onnx_weights.bin";
+        {
+            std::ofstream out(weights, std::ios::binary);
+            out << string(8, '\0');
+            out.write(reinterpret_cast<const char *>(w.data()),
+                      w.size() * sizeof(float));
+        }
+        auto entry = [](const string &key, const string &val)
+        { return Proto().s(1, key).s(2, val); };
+        Proto wTensor = Proto().i(1, 3).i(1, 4).i(2, 1).s(8, "w");
+        wTensor.m(13, entry("location", "onnx_weights.bin"))
+            .m(13, entry("offset", "8"))
+            .m(13, entry("length", "48"))
+            .i(14, 1);
+
+        Proto graph;
+        graph.m(1, node("Gemm", {"x", "w", "b"}, {"g"}, {intAttr("transB", 1)}))
+            .m(1, node("Relu", {"g"}, {"r"}))
+            .m(1, node("Constant", {}, {"lo"},
+                       {Proto().s(1, "value").m(
+                           5, floatTensor("", {}, {1}, true))}))
+            .m(1, node("Clip", {"r", "lo", "hi"}, {"c"}))
+            .m(1, node("Identity", {"c"}, {"i"}))
+            .m(1, node("Transpose", {"i"}, {"t"}))
+            .m(1, node("Cast", {"t"}, {"y"}, {intAttr("to", 10)}))
+            .m(5, wTensor)
+            .m(5, floatTensor("b", {3}, b, false))
+            .m(5, floatTensor("hi", {}, {20}, true))
+            .m(11, input("x", 1, {string("batch"), 4}))
+            .m(11, input("b", 1, {3}));
+        string path = writeModel("onnx_import.onnx", graph);
+
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        EXPECT_THROW(loadOnnx(runtime, path), Exception);
+        std::unordered_map<string, Tensor> tensors;
+        Graph g = loadOnnx(runtime, path, &tensors, {{"batch", 2}});
+        std::remove(path.c_str());
+        std::remove(weights.c_str());
+
+        EXPECT_EQ(g->getOperators().size(), 5u);
+        auto x = tensors.at("x"), y = tensors.at("y");
+        EXPECT_EQ(x->getDims(), (Shape{2, 4}));
+        EXPECT_EQ(y->getDims(), (Shape{3, 2}));
+        EXPECT_EQ(y->getDType(), DataType::Float16);
+        EXPECT_EQ(tensors.at("i"), tensors.at("c"));
+        EXPECT_FALSE(tensors.count("lo"));
+
+        g->dataMalloc();
+        x->setData(IncrementalGenerator());
+        runtime->run(g);
+        auto out = y->getRawDataPtr<uint16_t *>();
+        for (int i = 0; i < 2; ++i)
+            for (int j = 0; j < 3; ++j)
+            {
+                float acc = b[j];
+                for (int k = 0; k < 4; ++k)
+                    acc += float(i * 4 + k) * w[j * 4 + k];
+                float expect = std::min(std::max(acc, 1.f), 20.f);
+                EXPECT_EQ(fp16ToFp32(out[j * 2 + i]), expect)
+                    << "at " << i << ", " << j;
+            }
+    }
+
+    TEST(Onnx, ReportsUnsupportedOperators)
+    {
+        Proto graph;
+        graph.m(1, node("Reshape", {"x", "s"}, {"a"}))
+            .m(1, node("Relu", {"a"}, {"b"}))
+            .m(1, node("Softmax", {"b"}, {"c"}))
+            .m(1, node("Reshape", {"c", "s"}, {"d"}))
+            .m(11, input("x", 1, {2, 3}));
+        string path = writeModel("onnx_unsupported.onnx", graph);
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        try
+        {
+            loadOnnx(runtime, path);
+            ADD_FAILURE() << "import succeeded";
+        }
+        catch (const Exception &e)
+        {
+            string msg = e.what();
+            EXPECT_NE(msg.find("Reshape (2 nodes) Softmax (1 node)"),
+                      string::npos)
+                << msg;
+        }
+        std::remove(path.c_str());
+    }
+} // namespace infini
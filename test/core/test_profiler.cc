@@ -0,0 +1,86 @@
+#include "core/graph.h"
+#include "core/profiler.h"
+#include "core/runtime.h"
+#include "operators/element_wise.h"
+#include "operators/matmul.h"
+#include "operators/unary.h"
+
+#include "test.h"
+#include <sstream>
+
+namespace infini
+{
+    TEST(Profiler, RecordsOperators)
+    {
+        Ref<NativeCpuRuntimeObj> runtime = NativeCpuRuntimeObj::getInstance();
+        Graph g = make_ref<GraphObj>(runtime);
+        auto a = g->addTensor({2, 8, 16}, DataType::Float32);
+        auto b = g->addTensor({16, 4}, DataType::Float32);
+        auto bias = g->addTensor({4}, DataType::Float32);
+        auto mm = g->addOp<MatmulObj>(a, b, nullptr, false, false, bias);
+        auto relu = g->addOp<ReluObj>(mm->getOutput(), nullptr);
+        auto add = g->addOp<AddObj>(relu->getOutput(), bias, nullptr);
+        g->dataMalloc();
+        a->setData(IncrementalGenerator());
+        b->setData(IncrementalGenerator());
+        bias->setData(OneGenerator());
+
+        auto profiler = std::make_shared<Profiler>();
+        runtime->setProfiler(profiler);
+        runtime->run(g);
+        auto plan = runtime->compile(g);
+        runtime->run(plan);
+        runtime->setProfiler(nullptr);
+        // Neither runs nor plans compiled without a profiler record
+        runtime->run(g);
+        runtime->run(runtime->compile(g));
+        runtime->run(plan);
+
+        auto records = profiler->getRecords();
+        ASSERT_EQ(records.size(), 9u);
+        EXPECT_EQ(records[0].guid, mm->getGuid());
+        EXPECT_EQ(records[0].type, OpType::MatMul);
+        EXPECT_EQ(records[0].kernel, "MatmulBlocked_CPU");
+        EXPECT_EQ(records[0].flops, 2.0 * 2 * 8 * 4 * 16 + 2 * 8 * 4);
+        EXPECT_EQ(records[0].bytes, 4.0 * (2 * 8 * 16 + 16 * 4 + 4 + 2 * 8 * 4));
+        EXPECT_EQ(records[2].guid, add->getGuid());
+        EXPECT_EQ(records[2].flops, 2.0 * 8 * 4);
+        for (size_t i = 1; i < records.size(); ++i)
+            EXPECT_GE(records[i].begin,
+                      records[i - 1].begin + records[i - 1].duration);
+
+        auto summaries = profiler->summarize();
+        ASSERT_EQ(summaries.size(), 3u);
+        for (const auto &s : summaries)
+            EXPECT_EQ(s.calls, 3u);
+        for (size_t i = 1; i < summaries.size(); ++i)
+            EXPECT_GE(summaries[i - 1].seconds, summaries[i].seconds);
+
+        std::ostringstream trace;
+        profiler->writeChromeTrace(trace);
+        string json = trace.str();
+        EXPECT_EQ(json.rfind("{\"traceEvents\": [", 0), 0u);
+        size_t events = 0;
+        for (size_t pos = 0;
+             (pos = json.find("\"ph\": \"X\"", pos)) != string::npos; ++pos)
+            ++events;
+        EXPECT_EQ(events, 9u);
+        EXPECT_NE(json.find("\"cat\": \"MatmulBlocked_CPU\""), string::npos);
+
+        profiler->clear();
+        EXPECT_TRUE(profiler->getRecords().empty());
+        std::ostringstream summary;
+        profiler->printSummary(summary);
+        EXPECT_EQ(summary.str().find("nan"), string::npos);
+
+        // A plan keeps the profiler it was compiled with alive
+        std::weak_ptr<Profiler> weak = profiler;
+        runtime->setProfiler(profiler);
+        auto profiled = runtime->compile(g);
+        runtime->setProfiler(nullptr);
+        profiler.reset();
+        ASSERT_FALSE(weak.expired());
+        runtime->run(profiled);
+        EXPECT_EQ(weak.lock()->getRecords().size(), 3u);
+    }
+} // namespace infini
@@ -0,0 +1,95 @@
+#include "core/graph.h"
+#include "core/kernel.h"
+#include "core/runtime.h"
+#include "operators/element_wise.h"
+#include "operators/matmul.h"
+#include "operators/transpose.h"
+#include "operators/unary.h"
+
+#include "test.h"
+
+namespace infini
+{
+    TEST(Runtime, CompiledPlan)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        Graph g = make_ref<GraphObj>(runtime);
+        Tensor a = g->addTensor({2, 3, 4}, DataType::Float32);
+        Tensor b = g->addTensor({3, 5}, DataType::Float32);
+        Tensor bias = g->addTensor({5}, DataType::Float32);
+        auto transpose = g->addOp<TransposeObj>(a, nullptr, Shape{0, 2, 1});
+        auto matmul =
+            g->addOp<MatmulObj>(transpose->getOutput(), b, nullptr);
+        auto sub = g->addOp<SubObj>(matmul->getOutput(), bias, nullptr);
+        auto relu = g->addOp<ReluObj>(sub->getOutput(), nullptr);
+        g->dataMalloc();
+        auto plan = runtime->compile(g);
+        EXPECT_EQ(plan.launches.size(), g->getOperators().size());
+
+        auto output = relu->getOutput();
+        Tensor expected = make_ref<TensorObj>(output->getDims(),
+                                              DataType::Float32, runtime);
+        expected->setDataBlob(make_ref<BlobObj>(
+            runtime, runtime->alloc(expected->getBytes())));
+        auto check = [&]()
+        {
+            runtime->run(g);
+            std::memcpy(expected->getRawDataPtr<void *>(),
+                        output->getRawDataPtr<void *>(), output->getBytes());
+            std::memset(output->getRawDataPtr<void *>(), 0, output->getBytes());
+            runtime->run(plan);
+            EXPECT_TRUE(output->equalData(expected));
+        };
+        // the plan reads whatever data is bound at execution time
+        a->setData(IncrementalGenerator());
+        b->setData(OneGenerator());
+        bias->setData(IncrementalGenerator());
+        check();
+        b->setData(IncrementalGenerator());
+        bias->setData(ValGenerator<20>());
+        check();
+        runtime->dealloc(expected->getRawDataPtr<void *>());
+    }
+
+    TEST(Runtime, InterOpParallel)
+    {
+        auto runtime = NativeCpuRuntimeObj::getInstance();
+        Graph g = make_ref<GraphObj>(runtime);
+        // two independent branches feeding a matmul, each a chain of ops whose
+        // intermediates are recycled by the memory plan
+        Tensor a = g->addTensor({4, 64, 32}, DataType::Float32);
+        Tensor b = g->addTensor({4, 64, 48}, DataType::Float32);
+        auto ta = g->addOp<TransposeObj>(a, nullptr, Shape{0, 2, 1});
+        auto ra = g->addOp<ReluObj>(ta->getOutput(), nullptr);
+        auto ma = g->addOp<MulObj>(ra->getOutput(), ra->getOutput(), nullptr);
+        auto rb = g->addOp<ReluObj>(b, nullptr);
+        auto ab = g->addOp<AddObj>(rb->getOutput(), b, nullptr);
+        auto cb = g->addOp<ClipObj>(ab->getOutput(), nullptr, 0.f, 100.f);
+        auto matmul = g->addOp<MatmulObj>(ma->getOutput(), cb->getOutput(),
+                                          nullptr);
+        g->dataMalloc();
+        a->setData(IncrementalGenerator());
+        b->setData(IncrementalGenerator());
+        auto plan = runtime->compile(g);
+
+        auto output = matmul->getOutput();
+        runtime->run(plan);
+        vector<float> expected(output->getRawDataPtr<float *>(),
+                               output->getRawDataPtr<float *>() +
+                                   output->size());
+        for (int workers : {2, 3})
+        {
+            runtime->setInterOpThreads(workers);
+            EXPECT_EQ(runtime->getInterOpThreads(), workers);
+            for (int i = 0; i < 20; ++i)
+            {
+                std::memset(output->getRawDataPtr<void *>(), 0,
+                            output->getBytes());
+                runtime->run(plan);
+                EXPECT_TRUE(output->equalData(expected));
+            }
+        }
+        runtime->setInterOpThreads(1);
+        EXPECT_EQ(runtime->getInterOpThreads(), 1);
+    }
+} // namespace infini
@@ -0,0 +1,103 @@
+#include "core/graph.h"
+#include "core/runtime.h"
+#include "core/serialize.h"
+#include "operators/concat.h"
+#include "operators/element_wise.h"
+#include "operators/fused_element_wise.h"
+#include "operators/matmul.h"
+#include "operators/transpose.h"
+#include "operators/unary.h"
+
+#include "test.h"
+#include <cstdio>
+
+namespace infini
+{
+    TEST(Serialize, RoundTrip)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        Graph g = make_ref<GraphObj>(runtime);
+        auto x = g->addTensor({2, 8}, DataType::Float32);
+        auto w = g->addTensor({8, 6}, DataType::Float32);
+        auto bias = g->addTensor({6}, DataType::Float32);
+        auto k = g->addTensor({3, 2}, DataType::Float32);
+        auto s = g->addTensor({2}, DataType::Float32);
+        auto mm = g->addOp<MatmulObj>(x, w, nullptr)->getOutput();
+        auto a = g->addOp<AddObj>(mm, bias, nullptr)->getOutput();
+        auto r = g->addOp<ReluObj>(a, nullptr)->getOutput();
+        auto t = g->addOp<TransposeObj>(r, nullptr, vector<int>{1, 0})
+                     ->getOutput();
+        auto c = g->addOp<ConcatObj>(TensorVec{t, k}, nullptr, 0)->getOutput();
+        auto d = g->addOp<SubObj>(c, s, nullptr)->getOutput();
+        auto e = g->addOp<ClipObj>(d, nullptr, -1.f, 4.f)->getOutput();
+        auto out = g->addOp<CastObj>(e, nullptr, CastType::Float2Float16)
+                       ->getOutput();
+        // Matmul with its bias and Relu, Transpose, Concat, a fused Sub and
+        // Clip, Cast
+        g->optimize();
+        EXPECT_EQ(g->getOperators().size(), 5u);
+        g->dataMalloc();
+        x->setData(IncrementalGenerator());
+        w->setData(IncrementalGenerator());
+        bias->setData(ValGenerator<-40>());
+        k->setData(IncrementalGenerator());
+        s->setData(ValGenerator<2>());
+        runtime->run(g);
+
+        string path = ::testing::TempDir() + "serialize_round_trip.itg";
+        saveGraph(g, path, {w, bias, k, s});
+        Graph loaded = loadGraph(runtime, path);
+        std::remove(path.c_str()); // the mapping stays valid
+
+        const auto &ops = g->getOperators(), &loadedOps = loaded->getOperators();
+        ASSERT_EQ(loadedOps.size(), ops.size());
+        for (size_t i = 0; i < ops.size(); ++i)
+            EXPECT_EQ(loadedOps[i]->getOpType(), ops[i]->getOpType());
+        auto matmul = as<MatmulObj>(loadedOps[0]);
+        ASSERT_TRUE(matmul);
+        EXPECT_TRUE(matmul->getBias());
+        EXPECT_EQ(matmul->getMin(), 0.f);
+        auto fused = as<FusedElementWiseObj>(loadedOps[3]);
+        ASSERT_TRUE(fused);
+        EXPECT_EQ(fused->getSteps().size(), 2u);
+        EXPECT_EQ(fused->getSteps()[1].max, 4.f);
+
+        // Weights are bound in the mapping before dataMalloc and stay there
+        auto tensors = loaded->getTensors();
+        auto weight = tensors[1];
+        auto ptr = weight->getRawDataPtr<char *>();
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(ptr) % 64, 0u);
+        loaded->dataMalloc();
+        EXPECT_EQ(weight->getRawDataPtr<char *>(), ptr);
+        EXPECT_TRUE(weight->equalData(w));
+        EXPECT_TRUE(tensors[4]->equalData(s));
+
+        tensors[0]->setData(IncrementalGenerator());
+        runtime->run(loaded);
+        auto outputs = loaded->getOutputs();
+        ASSERT_EQ(outputs.size(), 1u);
+        EXPECT_EQ(outputs[0]->getDType(), DataType::Float16);
+        EXPECT_TRUE(outputs[0]->equalData(out));
+    }
+
+    TEST(Serialize, RejectsBadFiles)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        string path = ::testing::TempDir() + "serialize_bad.itg";
+        {
+            std::ofstream file(path, std::ios::binary);
+            file << "not a model file";
+        }
+        EXPECT_THROW(loadGraph(runtime, path), Exception);
+        {
+            // a file saved on a host of the other byte order
+            std::ofstream file(path, std::ios::binary);
+            uint32_t header[] = {1, 0x04030201, 0, 0};
+            file.write("ITGRAPH", 8);
+            file.write(reinterpret_cast<const char *>(header), sizeof(header));
+        }
+        EXPECT_THROW(loadGraph(runtime, path), Exception);
+        std::remove(path.c_str());
+        EXPECT_THROW(loadGraph(runtime, path), Exception);
+    }
+} // namespace infini
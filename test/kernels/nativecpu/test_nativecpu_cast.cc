@@ -0,0 +1,103 @@
+#include "core/graph.h"
+#include "core/runtime.h"
+#include "operators/unary.h"
+#include "utils/half.h"
+
+#include "test.h"
+
+namespace infini {
+
+template <typename S, typename D>
+static vector<D> runCast(const vector<S> &input, DataType dtype,
+                         CastType type) {
+    Runtime runtime = NativeCpuRuntimeObj::getInstance();
+    Graph g = make_ref<GraphObj>(runtime);
+    auto i = g->addTensor({(int)input.size()}, dtype);
+    auto op = g->addOp<CastObj>(i, nullptr, type);
+    g->dataMalloc();
+    std::memcpy(i->getRawDataPtr<void *>(), input.data(), i->getBytes());
+    runtime->run(g);
+    auto ptr = op->getOutput()->getRawDataPtr<D *>();
+    return vector<D>(ptr, ptr + input.size());
+}
+
+TEST(Cast, NativeCpuHalf) {
+    float inf = std::numeric_limits<float>::infinity();
+    // exact values, ties to even, overflow, subnormals and underflow
+    vector<float> input = {0.f,      -0.f,     1.f,       -2.5f,  65504.f,
+                           65520.f,  1.f + 0x1p-11f, 1.f + 0x3p-11f, 0x1p-24f,
+                           0x1p-26f, 0x1p-14f, -inf,      1e-3f};
+    vector<uint16_t> expected = {0x0000, 0x8000, 0x3c00, 0xc100, 0x7bff,
+                                 0x7c00, 0x3c00, 0x3c02, 0x0001, 0x0000,
+                                 0x0400, 0xfc00, 0x1419};
+    // long enough for the vector path and its tail
+    for (int rep = 0; rep < 3; ++rep)
+        for (size_t j = 0; j < 13; ++j) {
+            input.emplace_back(input[j]);
+            expected.emplace_back(expected[j]);
+        }
+    auto half =
+        runCast<float, uint16_t>(input, DataType::Float32,
+                                 CastType::Float2Float16);
+    EXPECT_EQ(half, expected);
+    for (size_t j = 0; j < half.size(); ++j)
+        EXPECT_EQ(fp32ToFp16(input[j]), expected[j]);
+
+    auto back =
+        runCast<uint16_t, float>(half, DataType::Float16,
+                                 CastType::Float162Float);
+    for (size_t j = 0; j < back.size(); ++j)
+        EXPECT_EQ(back[j], fp16ToFp32(half[j]));
+    EXPECT_EQ(back[4], 65504.f);
+    EXPECT_EQ(back[8], 0x1p-24f);
+}
+
+TEST(Cast, NativeCpuBFloat16) {
+    vector<float> input;
+    for (int j = 0; j < 37; ++j)
+        input.emplace_back((j - 18) * 1.37e3f + 0.001f * j);
+    input[5] = 1.f + 0x1p-8f;   // tie, rounds to even
+    input[6] = 1.f + 0x3p-8f;   // tie, rounds up
+    input[7] = std::numeric_limits<float>::quiet_NaN();
+    auto bf16 = runCast<float, uint16_t>(input, DataType::Float32,
+                                         CastType::Float2BFloat16);
+    EXPECT_EQ(bf16[5], 0x3f80);
+    EXPECT_EQ(bf16[6], 0x3f82);
+    EXPECT_EQ(bf16[7] & 0x7fc0, 0x7fc0);
+    auto back = runCast<uint16_t, float>(bf16, DataType::BFloat16,
+                                         CastType::BFloat162Float);
+    for (size_t j = 0; j < input.size(); ++j) {
+        EXPECT_EQ(bf16[j], fp32ToBf16(input[j]));
+        if (j != 7) {
+            EXPECT_NEAR(back[j], input[j], std::abs(input[j]) / 128);
+        }
+    }
+}
+
+TEST(Cast, NativeCpuSaturate) {
+    vector<float> f = {1.9f, -1.9f, 127.f, 300.f, -300.f,
+                       std::numeric_limits<float>::quiet_NaN()};
+    EXPECT_EQ((runCast<float, int8_t>(f, DataType::Float32,
+                                      CastType::Float2Int8)),
+              (vector<int8_t>{1, -1, 127, 127, -128, 0}));
+    EXPECT_EQ((runCast<float, int32_t>(f, DataType::Float32,
+                                       CastType::Float2Int32)),
+              (vector<int32_t>{1, -1, 127, 300, -300, 0}));
+    vector<int32_t> i32 = {5, -200, 40000, -40000};
+    EXPECT_EQ((runCast<int32_t, int8_t>(i32, DataType::Int32,
+                                        CastType::Int322Int8)),
+              (vector<int8_t>{5, -128, 127, -128}));
+    EXPECT_EQ((runCast<int32_t, int16_t>(i32, DataType::Int32,
+                                         CastType::Int322Int16)),
+              (vector<int16_t>{5, -200, 32767, -32768}));
+    vector<int64_t> i64 = {-1, 7, int64_t(1) << 40};
+    EXPECT_EQ((runCast<int64_t, uint32_t>(i64, DataType::Int64,
+                                          CastType::Int642Uint32)),
+              (vector<uint32_t>{0, 7, 0xffffffffu}));
+    vector<uint8_t> u8 = {0, 200, 255};
+    EXPECT_EQ((runCast<uint8_t, float>(u8, DataType::UInt8,
+                                       CastType::Uint82Float)),
+              (vector<float>{0.f, 200.f, 255.f}));
+}
+
+} // namespace infini
@@ -1,6 +1,7 @@
 #include "core/graph.h"
 #include "core/runtime.h"
 #include "operators/element_wise.h"
+#include "utils/operator_utils.h"
 
 #include "test.h"
 
@@ -41,4 +42,50 @@ TEST(ElementWise, NativeCpu) {
         Shape{2, 1, 1}, ExpectOutput{0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11});
 }
 
+// Compare Add against a per-element reference walk over the broadcast.
+void testAddBroadcastNativeCpu(const Shape &shape1, const Shape &shape2) {
+    Runtime runtime = NativeCpuRuntimeObj::getInstance();
+    Graph g = make_ref<GraphObj>(runtime);
+    auto t1 = g->addTensor(shape1, DataType::Float32);
+    auto t2 = g->addTensor(shape2, DataType::Float32);
+    auto op = g->addOp<AddObj>(t1, t2, nullptr);
+    g->dataMalloc();
+    t1->setData(IncrementalGenerator());
+    t2->setData(IncrementalGenerator());
+    runtime->run(g);
+
+    auto shapeC = op->getOutput()->getDims();
+    auto rank = shapeC.size();
+    Shape a(rank, 1), b(rank, 1), strideA(rank), strideB(rank);
+    std::copy(shape1.begin(), shape1.end(), a.begin() + (rank - shape1.size()));
+    std::copy(shape2.begin(), shape2.end(), b.begin() + (rank - shape2.size()));
+    for (int i = rank - 1, pA = 1, pB = 1; i >= 0; --i) {
+        strideA[i] = pA, pA *= a[i];
+        strideB[i] = pB, pB *= b[i];
+    }
+    ExpectOutput ans(op->getOutput()->size());
+    for (size_t i = 0; i < ans.size(); ++i) {
+        auto index = locate_index(i, shapeC);
+        ans[i] = delocate_index(index, a, strideA) +
+                 delocate_index(index, b, strideB);
+    }
+    EXPECT_TRUE(op->getOutput()->equalData(ans));
+}
+
+TEST(ElementWise, NativeCpuBroadcast) {
+    // same shape
+    testAddBroadcastNativeCpu(Shape{3, 5, 7}, Shape{3, 5, 7});
+    // scalar
+    testAddBroadcastNativeCpu(Shape{3, 5, 7}, Shape{1});
+    testAddBroadcastNativeCpu(Shape{1}, Shape{3, 5, 7});
+    // row and column
+    testAddBroadcastNativeCpu(Shape{3, 5, 7}, Shape{7});
+    testAddBroadcastNativeCpu(Shape{3, 5, 7}, Shape{3, 5, 1});
+    // both inputs broadcast
+    testAddBroadcastNativeCpu(Shape{3, 1, 7}, Shape{1, 5, 1});
+    // large enough to be chunked and split across threads
+    testAddBroadcastNativeCpu(Shape{64, 1, 700}, Shape{1, 33, 700});
+    testAddBroadcastNativeCpu(Shape{40000}, Shape{40000});
+}
+
 } // namespace infini
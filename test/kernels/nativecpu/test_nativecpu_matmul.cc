@@ -0,0 +1,324 @@
+#include "core/graph.h"
+#include "core/kernel.h"
+#include "core/runtime.h"
+#include "operators/matmul.h"
+#include "utils/half.h"
+#include "utils/operator_utils.h"
+#include "utils/quantize.h"
+
+#include "test.h"
+
+namespace infini {
+
+// Small integers keep every partial sum exact in float32.
+static void smallIntGenerator(void *data, size_t size, DataType dataType) {
+    IT_ASSERT(dataType == DataType::Float32);
+    auto ptr = reinterpret_cast<float *>(data);
+    for (size_t i = 0; i < size; ++i)
+        ptr[i] = float(int(i * 7 % 11) - 5);
+}
+
+// Reference matmul on 3-D tensors whose batch dimension may be broadcast.
+static vector<float> naiveMatmul(const vector<float> &a, const Shape &shapeA,
+                                 bool transA, const vector<float> &b,
+                                 const Shape &shapeB, bool transB) {
+    int batch = std::max(shapeA[0], shapeB[0]);
+    int m = transA ? shapeA[2] : shapeA[1];
+    int k = transA ? shapeA[1] : shapeA[2];
+    int n = transB ? shapeB[1] : shapeB[2];
+    vector<float> c((size_t)batch * m * n, 0.f);
+    for (int bt = 0; bt < batch; ++bt) {
+        const float *pa = a.data() + (shapeA[0] == 1 ? 0 : bt) * m * k;
+        const float *pb = b.data() + (shapeB[0] == 1 ? 0 : bt) * k * n;
+        for (int i = 0; i < m; ++i)
+            for (int j = 0; j < n; ++j) {
+                float sum = 0;
+                for (int p = 0; p < k; ++p)
+                    sum += (transA ? pa[p * m + i] : pa[i * k + p]) *
+                           (transB ? pb[j * k + p] : pb[p * n + j]);
+                c[((size_t)bt * m + i) * n + j] = sum;
+            }
+    }
+    return c;
+}
+
+static void testMatmulNativeCpu(const Shape &shapeA, const Shape &shapeB,
+                                bool transA, bool transB,
+                                bool constantB = false) {
+    Runtime runtime = NativeCpuRuntimeObj::getInstance();
+    Graph g = make_ref<GraphObj>(runtime);
+    auto a = g->addTensor(shapeA, DataType::Float32);
+    auto b = g->addTensor(shapeB, DataType::Float32);
+    auto op = g->addOp<MatmulObj>(a, b, nullptr, transA, transB);
+    if (constantB)
+        b->setConstant();
+    g->dataMalloc();
+    a->setData(smallIntGenerator);
+    b->setData(smallIntGenerator);
+    runtime->run(g);
+
+    vector<float> dataA(a->size()), dataB(b->size());
+    smallIntGenerator(dataA.data(), dataA.size(), DataType::Float32);
+    smallIntGenerator(dataB.data(), dataB.size(), DataType::Float32);
+    auto expected = naiveMatmul(dataA, shapeA, transA, dataB, shapeB, transB);
+    EXPECT_TRUE(op->getOutput()->equalData(expected));
+    if (constantB) {
+        // a constant B is packed once when the graph is compiled
+        op->getOutput()->setData(ZeroGenerator());
+        runtime->run(runtime->compile(g));
+        EXPECT_TRUE(op->getOutput()->equalData(expected));
+    }
+}
+
+TEST(Matmul, NativeCpu) {
+    Runtime runtime = NativeCpuRuntimeObj::getInstance();
+    Graph g = make_ref<GraphObj>(runtime);
+    auto a = g->addTensor({2, 3}, DataType::Float32);
+    auto b = g->addTensor({3, 2}, DataType::Float32);
+    auto op = g->addOp<MatmulObj>(a, b, nullptr);
+    g->dataMalloc();
+    a->setData(IncrementalGenerator());
+    b->setData(IncrementalGenerator());
+
+    runtime->run(g);
+    EXPECT_TRUE(op->getOutput()->equalData(vector<float>{10, 13, 28, 40}));
+}
+
+TEST(Matmul, NativeCpuTransposeAndBroadcast) {
+    testMatmulNativeCpu({2, 5, 7}, {2, 7, 3}, false, false);
+    testMatmulNativeCpu({2, 7, 5}, {1, 7, 3}, true, false);
+    testMatmulNativeCpu({1, 5, 7}, {3, 3, 7}, false, true);
+    testMatmulNativeCpu({3, 7, 5}, {3, 3, 7}, true, true);
+}
+
+TEST(Matmul, NativeCpuBlockEdges) {
+    // Not a multiple of any tile size, and k spans several k-blocks.
+    testMatmulNativeCpu({1, 151, 601}, {1, 601, 37}, false, false);
+    testMatmulNativeCpu({2, 601, 151}, {1, 37, 601}, true, true);
+}
+
+// A constant B is packed once when the kernel is prepared.
+TEST(Matmul, NativeCpuPrepackedB) {
+    testMatmulNativeCpu({2, 7, 5}, {1, 7, 3}, true, false, true);
+    testMatmulNativeCpu({3, 7, 5}, {3, 3, 7}, true, true, true);
+    testMatmulNativeCpu({1, 151, 601}, {1, 601, 37}, false, false, true);
+    testMatmulNativeCpu({2, 601, 151}, {1, 37, 601}, true, true, true);
+
+    // half operands are widened as B is packed
+    Runtime runtime = NativeCpuRuntimeObj::getInstance();
+    vector<Graph> graphs;
+    vector<Tensor> outputs;
+    for (bool constant : {false, true}) {
+        Graph g = graphs.emplace_back(make_ref<GraphObj>(runtime));
+        auto a = g->addTensor({2, 9, 300}, DataType::Float16);
+        auto b = g->addTensor({2, 300, 20}, DataType::Float16);
+        outputs.emplace_back(
+            g->addOp<MatmulObj>(a, b, nullptr, false, false)->getOutput());
+        if (constant)
+            b->setConstant();
+        g->dataMalloc();
+        for (auto &t : {a, b}) {
+            auto ptr = t->getRawDataPtr<uint16_t *>();
+            for (size_t i = 0; i < t->size(); ++i)
+                ptr[i] = fp32ToFp16(float(int(i * 7 % 11) - 5) * 0.25f);
+        }
+        runtime->run(runtime->compile(g));
+    }
+    EXPECT_TRUE(outputs[1]->equalData(outputs[0]));
+}
+
+// A half bias is widened once when it is constant and on every run otherwise.
+TEST(Matmul, NativeCpuHalfBias) {
+    Runtime runtime = NativeCpuRuntimeObj::getInstance();
+    vector<Graph> graphs;
+    vector<ExecutionPlan> plans;
+    vector<Tensor> biases, outputs;
+    for (bool constant : {false, true}) {
+        Graph g = graphs.emplace_back(make_ref<GraphObj>(runtime));
+        auto a = g->addTensor({2, 9, 30}, DataType::Float16);
+        auto b = g->addTensor({1, 30, 20}, DataType::Float16);
+        auto bias = biases.emplace_back(g->addTensor({20}, DataType::Float16));
+        outputs.emplace_back(
+            g->addOp<MatmulObj>(a, b, nullptr, false, false, bias)
+                ->getOutput());
+        if (constant)
+            bias->setConstant();
+        g->dataMalloc();
+        for (auto &t : {a, b, bias}) {
+            auto ptr = t->getRawDataPtr<uint16_t *>();
+            for (size_t i = 0; i < t->size(); ++i)
+                ptr[i] = fp32ToFp16(float(int(i * 7 % 11) - 5) * 0.25f);
+        }
+        plans.emplace_back(runtime->compile(g));
+        runtime->run(plans.back());
+    }
+    EXPECT_TRUE(outputs[1]->equalData(outputs[0]));
+
+    // a bias that is not constant may change between runs of a plan
+    auto ptr = biases[0]->getRawDataPtr<uint16_t *>();
+    for (size_t i = 0; i < biases[0]->size(); ++i)
+        ptr[i] = fp32ToFp16(100.f);
+    runtime->run(plans[0]);
+    EXPECT_FALSE(outputs[1]->equalData(outputs[0]));
+}
+
+// Bias and clamp applied in the GEMM store, with the bias broadcast along
+// columns or along rows and batches.
+static void testMatmulEpilogue(const Shape &shapeBias) {
+    Shape shapeA = {2, 13, 600}, shapeB = {1, 600, 21};
+    Runtime runtime = NativeCpuRuntimeObj::getInstance();
+    Graph g = make_ref<GraphObj>(runtime);
+    auto a = g->addTensor(shapeA, DataType::Float32);
+    auto b = g->addTensor(shapeB, DataType::Float32);
+    auto bias = g->addTensor(shapeBias, DataType::Float32);
+    auto op = g->addOp<MatmulObj>(a, b, nullptr, false, false, bias);
+    op->clampOutput(0.f, {});
+    op->clampOutput(-100.f, 200.f);
+    EXPECT_EQ(op->getMin(), 0.f);
+    EXPECT_EQ(op->getMax(), 200.f);
+    g->dataMalloc();
+    a->setData(smallIntGenerator);
+    b->setData(smallIntGenerator);
+    bias->setData(IncrementalGenerator());
+    runtime->run(g);
+
+    vector<float> dataA(a->size()), dataB(b->size());
+    smallIntGenerator(dataA.data(), dataA.size(), DataType::Float32);
+    smallIntGenerator(dataB.data(), dataB.size(), DataType::Float32);
+    auto expected = naiveMatmul(dataA, shapeA, false, dataB, shapeB, false);
+    auto shapeC = op->getOutput()->getDims();
+    for (size_t i = 0; i < expected.size(); ++i) {
+        auto index = locate_index(i, shapeC);
+        size_t biasIndex = 0;
+        for (size_t d = 0, offset = shapeC.size() - shapeBias.size();
+             d < shapeBias.size(); ++d)
+            biasIndex = biasIndex * shapeBias[d] +
+                        (shapeBias[d] == 1 ? 0 : index[offset + d]);
+        expected[i] = std::min(std::max(expected[i] + biasIndex, 0.f), 200.f);
+    }
+    EXPECT_TRUE(op->getOutput()->equalData(expected));
+}
+
+TEST(Matmul, NativeCpuEpilogue) {
+    testMatmulEpilogue({21});
+    testMatmulEpilogue({2, 13, 1});
+    testMatmulEpilogue({1});
+}
+
+// uint8 x int8 matmul against an int32 reference, dequantized to float with
+// per-channel scales or requantized to int8 through a bias and a Relu.
+static void testMatmulQuantized(const Shape &shapeA, const Shape &shapeB,
+                                bool transA, bool transB, DataType outType,
+                                bool constantB = false) {
+    Runtime runtime = NativeCpuRuntimeObj::getInstance();
+    Graph g = make_ref<GraphObj>(runtime);
+    auto a = g->addTensor(shapeA, DataType::UInt8);
+    auto b = g->addTensor(shapeB, DataType::Int8);
+    int n = transB ? shapeB[1] : shapeB[2];
+    MatmulQuantization quant;
+    quant.scaleA = 0.5f;
+    quant.zeroA = 7;
+    quant.scaleB.clear();
+    for (int j = 0; j < n; ++j)
+        quant.scaleB.emplace_back(0.01f * (j + 1));
+    quant.outType = outType;
+    quant.scaleC = 4.f;
+    quant.zeroC = -3;
+    Tensor bias;
+    if (!(outType == DataType::Float32))
+        bias = g->addTensor({n}, DataType::Float32);
+    auto op =
+        g->addOp<MatmulObj>(a, b, nullptr, transA, transB, bias, quant);
+    if (bias)
+        op->clampOutput(0.f, {});
+    EXPECT_EQ(op->getOutput()->getDType(), outType);
+    if (constantB)
+        b->setConstant();
+    g->dataMalloc();
+    auto ptrA = a->getRawDataPtr<uint8_t *>();
+    auto ptrB = b->getRawDataPtr<int8_t *>();
+    for (size_t i = 0; i < a->size(); ++i)
+        ptrA[i] = i * 37 % 256;
+    for (size_t i = 0; i < b->size(); ++i)
+        ptrB[i] = int(i * 53 % 256) - 128;
+    if (bias)
+        for (int j = 0; j < n; ++j)
+            bias->getRawDataPtr<float *>()[j] = 10.f * (j % 5) - 20.f;
+    runtime->run(g);
+
+    vector<float> dataA(a->size()), dataB(b->size());
+    for (size_t i = 0; i < a->size(); ++i)
+        dataA[i] = ptrA[i] - quant.zeroA;
+    for (size_t i = 0; i < b->size(); ++i)
+        dataB[i] = ptrB[i];
+    // exact: every partial sum is an integer below 2^24
+    auto sums = naiveMatmul(dataA, shapeA, transA, dataB, shapeB, transB);
+    for (size_t i = 0; i < sums.size(); ++i) {
+        int j = i % n;
+        float v = quant.scaleA * quant.scaleB[j] * sums[i];
+        if (outType == DataType::Float32) {
+            ASSERT_EQ(op->getOutput()->getRawDataPtr<float *>()[i], v);
+            continue;
+        }
+        v = std::max(v + bias->getRawDataPtr<float *>()[j], 0.f);
+        float q = std::nearbyint(v / quant.scaleC) + quant.zeroC;
+        ASSERT_EQ(op->getOutput()->getRawDataPtr<int8_t *>()[i],
+                  (int8_t)std::min(std::max(q, -128.f), 127.f));
+    }
+}
+
+TEST(Matmul, NativeCpuQuantized) {
+    testMatmulQuantized({2, 13, 70}, {1, 21, 70}, false, true,
+                        DataType::Float32);
+    // odd k spanning several k-blocks
+    testMatmulQuantized({1, 1101, 9}, {1, 1101, 37}, true, false,
+                        DataType::Float32);
+    testMatmulQuantized({3, 17, 40}, {3, 40, 19}, false, false,
+                        DataType::Int8);
+    // column sums of a constant B are taken once, per matrix of B
+    testMatmulQuantized({3, 17, 40}, {1, 19, 40}, false, true,
+                        DataType::Int8, true);
+}
+
+// Scales calibrated from float data keep the quantized matmul close to fp32.
+TEST(Matmul, NativeCpuCalibrated) {
+    Shape shapeA = {1, 32, 256}, shapeB = {1, 256, 48};
+    Runtime runtime = NativeCpuRuntimeObj::getInstance();
+    Graph g = make_ref<GraphObj>(runtime);
+    auto a = g->addTensor(shapeA, DataType::Float32);
+    auto b = g->addTensor(shapeB, DataType::Float32);
+    g->dataMalloc();
+    vector<float> dataA(a->size()), dataB(b->size());
+    for (size_t i = 0; i < dataA.size(); ++i)
+        dataA[i] = float(i * 7919 % 1000) / 250.f - 1.f;
+    for (size_t i = 0; i < dataB.size(); ++i)
+        dataB[i] = (float(i * 104729 % 2001) / 1000.f - 1.f) * (i % 48 + 1);
+    std::memcpy(a->getRawDataPtr<float *>(), dataA.data(), a->getBytes());
+    std::memcpy(b->getRawDataPtr<float *>(), dataB.data(), b->getBytes());
+
+    MatmulQuantization quant;
+    auto params = calibrateUInt8({a});
+    quant.scaleA = params.scale;
+    quant.zeroA = params.zeroPoint;
+    quant.scaleB = calibrateInt8(b, false);
+    EXPECT_EQ(quant.scaleB.size(), 48u);
+
+    Graph gq = make_ref<GraphObj>(runtime);
+    auto qa = gq->addTensor(shapeA, DataType::UInt8);
+    auto qb = gq->addTensor(shapeB, DataType::Int8);
+    auto op = gq->addOp<MatmulObj>(qa, qb, nullptr, false, false, nullptr,
+                                   quant);
+    gq->dataMalloc();
+    quantizeUInt8(a, qa, params);
+    quantizeInt8(b, qb, quant.scaleB, false);
+    runtime->run(gq);
+
+    auto expected = naiveMatmul(dataA, shapeA, false, dataB, shapeB, false);
+    auto out = op->getOutput()->getRawDataPtr<float *>();
+    for (size_t i = 0; i < expected.size(); ++i) {
+        // column j of B spans [-(j + 1), j + 1]
+        EXPECT_NEAR(out[i], expected[i], 0.5f * (i % 48 + 1)) << "at " << i;
+    }
+}
+
+} // namespace infini
@@ -0,0 +1,108 @@
+#include "core/graph.h"
+#include "core/runtime.h"
+#include "operators/element_wise.h"
+#include "operators/matmul.h"
+#include "operators/transpose.h"
+#include "operators/unary.h"
+#include "utils/half.h"
+
+#include "test.h"
+
+namespace infini {
+
+using GraphBuilder = std::function<Tensor(Graph, DataType)>;
+
+static float toFp32(uint16_t val, DataType dtype) {
+    return dtype == DataType::Float16 ? fp16ToFp32(val) : bf16ToFp32(val);
+}
+
+static uint16_t fromFp32(float val, DataType dtype) {
+    return dtype == DataType::Float16 ? fp32ToFp16(val) : fp32ToBf16(val);
+}
+
+// Builds the graph once in fp32 and once in `dtype`, feeding both the same
+// values representable in `dtype`. Reduced kernels compute in fp32 and round
+// once on store, so the output of a single op (or of ops that do not round,
+// or are fused) must be the fp32 output rounded.
+static void testReduced(DataType dtype, const GraphBuilder &build,
+                        bool optimize = false) {
+    Runtime runtime = NativeCpuRuntimeObj::getInstance();
+    Graph g32 = make_ref<GraphObj>(runtime), g16 = make_ref<GraphObj>(runtime);
+    auto out32 = build(g32, DataType::Float32);
+    auto out16 = build(g16, dtype);
+    if (optimize) {
+        g32->optimize();
+        g16->optimize();
+    }
+    g32->dataMalloc();
+    g16->dataMalloc();
+    auto in32 = g32->getInputs(), in16 = g16->getInputs();
+    ASSERT_EQ(in32.size(), in16.size());
+    for (size_t i = 0; i < in16.size(); ++i) {
+        auto src = in16[i]->getRawDataPtr<uint16_t *>();
+        auto dst = in32[i]->getRawDataPtr<float *>();
+        for (size_t j = 0; j < in16[i]->size(); ++j) {
+            src[j] = fromFp32(float(int((i + j) * 37 % 23) - 11) * 0.37f,
+                              dtype);
+            dst[j] = toFp32(src[j], dtype);
+        }
+    }
+    runtime->run(g32);
+    runtime->run(g16);
+
+    auto ptr32 = out32->getRawDataPtr<float *>();
+    auto ptr16 = out16->getRawDataPtr<uint16_t *>();
+    for (size_t j = 0; j < out16->size(); ++j)
+        ASSERT_EQ(ptr16[j], fromFp32(ptr32[j], dtype)) << "at " << j;
+}
+
+static void testReducedAll(DataType dtype) {
+    // broadcast element-wise, long enough for several conversion blocks
+    testReduced(dtype, [](Graph g, DataType dt) {
+        auto a = g->addTensor({3, 5, 700}, dt);
+        auto b = g->addTensor({5, 1}, dt);
+        return g->addOp<AddObj>(a, b, nullptr)->getOutput();
+    });
+    testReduced(dtype, [](Graph g, DataType dt) {
+        auto a = g->addTensor({2, 300}, dt);
+        auto b = g->addTensor({300}, dt);
+        return g->addOp<DivObj>(a, b, nullptr)->getOutput();
+    });
+    // unary
+    testReduced(dtype, [](Graph g, DataType dt) {
+        auto a = g->addTensor({7, 61}, dt);
+        auto r = g->addOp<ReluObj>(a, nullptr)->getOutput();
+        return g->addOp<ClipObj>(r, nullptr, 0.5f, 2.f)->getOutput();
+    });
+    // transpose
+    testReduced(dtype, [](Graph g, DataType dt) {
+        auto a = g->addTensor({3, 4, 5}, dt);
+        return g->addOp<TransposeObj>(a, nullptr, vector<int>{2, 0, 1})
+            ->getOutput();
+    });
+    // fused element-wise chain
+    testReduced(
+        dtype,
+        [](Graph g, DataType dt) {
+            auto a = g->addTensor({4, 600}, dt);
+            auto b = g->addTensor({600}, dt);
+            auto c = g->addOp<SubObj>(a, b, nullptr)->getOutput();
+            auto d = g->addOp<MulObj>(c, a, nullptr)->getOutput();
+            return g->addOp<ReluObj>(d, nullptr)->getOutput();
+        },
+        true);
+    // matmul with a transposed operand, batch broadcast and a bias
+    testReduced(dtype, [](Graph g, DataType dt) {
+        auto a = g->addTensor({2, 13, 300}, dt);
+        auto b = g->addTensor({1, 21, 300}, dt);
+        auto bias = g->addTensor({21}, dt);
+        return g->addOp<MatmulObj>(a, b, nullptr, false, true, bias)
+            ->getOutput();
+    });
+}
+
+TEST(Reduced, NativeCpuFloat16) { testReducedAll(DataType::Float16); }
+
+TEST(Reduced, NativeCpuBFloat16) { testReducedAll(DataType::BFloat16); }
+
+} // namespace infini
@@ -24,4 +24,48 @@ TEST(Transpose, NativeCpu) {
                                                           8, 9, 10, 11, 20, 21, 22, 23}));
 }
 
+// Compare against a per-element walk over the input.
+void testTransposeNativeCpu(const Shape &shape, const Shape &permute) {
+    Runtime runtime = NativeCpuRuntimeObj::getInstance();
+    Graph g = make_ref<GraphObj>(runtime);
+    auto input = g->addTensor(shape, DataType::Float32);
+    auto op = g->addOp<TransposeObj>(input, nullptr, permute);
+    g->dataMalloc();
+    input->setData(IncrementalGenerator());
+    runtime->run(g);
+
+    size_t rank = shape.size();
+    vector<float> ans(input->size());
+    for (size_t inIdx = 0; inIdx < ans.size(); ++inIdx) {
+        Shape pos(rank);
+        for (size_t i = rank, rest = inIdx; i > 0; --i) {
+            pos[i - 1] = rest % shape[i - 1];
+            rest /= shape[i - 1];
+        }
+        size_t outIdx = 0;
+        for (size_t j = 0; j < rank; ++j)
+            outIdx = outIdx * shape[permute[j]] + pos[permute[j]];
+        ans[outIdx] = inIdx;
+    }
+    EXPECT_TRUE(op->getOutput()->equalData(ans));
+}
+
+TEST(Transpose, NativeCpuTiled) {
+    // plain 2-D, with partial tiles and partial 8x8 blocks
+    testTransposeNativeCpu({37, 45}, {1, 0});
+    testTransposeNativeCpu({64, 96}, {1, 0});
+    // innermost axis kept, merged into row copies
+    testTransposeNativeCpu({3, 50, 20, 7}, {1, 0, 2, 3});
+    // batched 2-D transposes
+    testTransposeNativeCpu({3, 50, 20, 7}, {0, 3, 1, 2});
+    testTransposeNativeCpu({2, 33, 17, 19}, {3, 2, 1, 0});
+    // size-1 dims dropped before reduction
+    testTransposeNativeCpu({4, 1, 9, 1, 5}, {4, 2, 0, 3, 1});
+    testTransposeNativeCpu({1, 1, 1}, {2, 0, 1});
+    // identity
+    testTransposeNativeCpu({6, 7, 8}, {0, 1, 2});
+    // large enough to run in parallel
+    testTransposeNativeCpu({8, 129, 200}, {2, 0, 1});
+}
+
 } // namespace infini